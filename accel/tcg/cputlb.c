@@ -284,6 +284,9 @@ static void tlb_mmu_flush_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast)
     desc->vindex = 0;
     memset(fast->table, -1, sizeof_tlb(fast));
     memset(desc->vtable, -1, sizeof(desc->vtable));
+    desc->subpage_index = 0;
+    memset(desc->subpage_base, -1, sizeof(desc->subpage_base));
+    memset(desc->subpage_table, -1, sizeof(desc->subpage_table));
 }
 
 static void tlb_flush_one_mmuidx_locked(CPUState *cpu, int mmu_idx,
@@ -499,6 +502,27 @@ static inline void tlb_flush_vtlb_page_locked(CPUState *cpu, int mmu_idx,
     tlb_flush_vtlb_page_mask_locked(cpu, mmu_idx, page, -1);
 }
 
+/*
+ * Called with tlb_c.lock held.  The sub-page entries always carry
+ * TLB_INVALID_MASK, so match them by their base address instead of
+ * with tlb_flush_entry_mask_locked.
+ */
+static void tlb_flush_subpage_mask_locked(CPUState *cpu, int mmu_idx,
+                                          vaddr page, vaddr mask)
+{
+    CPUTLBDesc *d = &cpu->neg.tlb.d[mmu_idx];
+    int k;
+
+    assert_cpu_is_self(cpu);
+    mask &= TARGET_PAGE_MASK;
+    for (k = 0; k < CPU_SUBPAGE_TLB_SIZE; k++) {
+        if ((d->subpage_base[k] & mask) == (page & mask)) {
+            d->subpage_base[k] = -1;
+            memset(&d->subpage_table[k], -1, sizeof(d->subpage_table[k]));
+        }
+    }
+}
+
 static void tlb_flush_page_locked(CPUState *cpu, int midx, vaddr page)
 {
     vaddr lp_addr = cpu->neg.tlb.d[midx].large_page_addr;
@@ -515,6 +539,7 @@ static void tlb_flush_page_locked(CPUState *cpu, int midx, vaddr page)
             tlb_n_used_entries_dec(cpu, midx);
         }
         tlb_flush_vtlb_page_locked(cpu, midx, page);
+        tlb_flush_subpage_mask_locked(cpu, midx, page, -1);
     }
 }
 
@@ -707,6 +732,7 @@ static void tlb_flush_range_locked(CPUState *cpu, int midx,
             tlb_n_used_entries_dec(cpu, midx);
         }
         tlb_flush_vtlb_page_mask_locked(cpu, midx, page, mask);
+        tlb_flush_subpage_mask_locked(cpu, midx, page, mask);
     }
 }
 
@@ -934,6 +960,12 @@ void tlb_reset_dirty(CPUState *cpu, uintptr_t start, uintptr_t length)
             tlb_reset_dirty_range_locked(&desc->vfulltlb[i], &desc->vtable[i],
                                          start, length);
         }
+
+        for (i = 0; i < CPU_SUBPAGE_TLB_SIZE; i++) {
+            tlb_reset_dirty_range_locked(&desc->subpage_fulltlb[i],
+                                         &desc->subpage_table[i],
+                                         start, length);
+        }
     }
     qemu_spin_unlock(&cpu->neg.tlb.c.lock);
 }
@@ -966,6 +998,14 @@ static void tlb_set_dirty(CPUState *cpu, vaddr addr)
         for (k = 0; k < CPU_VTLB_SIZE; k++) {
             tlb_set_dirty1_locked(&cpu->neg.tlb.d[mmu_idx].vtable[k], addr);
         }
+        for (k = 0; k < CPU_SUBPAGE_TLB_SIZE; k++) {
+            CPUTLBEntry *e = &cpu->neg.tlb.d[mmu_idx].subpage_table[k];
+
+            /* Sub-page entries keep TLB_INVALID_MASK set */
+            if ((e->addr_write & ~TLB_INVALID_MASK) == (addr | TLB_NOTDIRTY)) {
+                e->addr_write &= ~TLB_NOTDIRTY;
+            }
+        }
     }
     qemu_spin_unlock(&cpu->neg.tlb.c.lock);
 }
@@ -1179,6 +1219,27 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
 
     copy_tlb_helper_locked(te, &tn);
     tlb_n_used_entries_inc(cpu, mmu_idx);
+
+    /*
+     * Remember sub-page translations for subpage_tlb_hit; a size of 0
+     * is the translator asking for the check to be repeated every time.
+     */
+    if (full->lg_page_size && full->lg_page_size < TARGET_PAGE_BITS) {
+        vaddr base = addr & -((vaddr)1 << full->lg_page_size);
+        unsigned sidx;
+
+        for (sidx = 0; sidx < CPU_SUBPAGE_TLB_SIZE; sidx++) {
+            if (desc->subpage_base[sidx] == base) {
+                break;
+            }
+        }
+        if (sidx == CPU_SUBPAGE_TLB_SIZE) {
+            sidx = desc->subpage_index++ % CPU_SUBPAGE_TLB_SIZE;
+        }
+        desc->subpage_base[sidx] = base;
+        copy_tlb_helper_locked(&desc->subpage_table[sidx], &tn);
+        desc->subpage_fulltlb[sidx] = *full;
+    }
     qemu_spin_unlock(&tlb->c.lock);
 }
 
@@ -1270,13 +1331,16 @@ static inline void cpu_unaligned_access(CPUState *cpu, vaddr addr,
 
 static MemoryRegionSection *
 io_prepare(hwaddr *out_offset, CPUState *cpu, hwaddr xlat,
-           MemTxAttrs attrs, vaddr addr, uintptr_t retaddr)
+           MemTxAttrs attrs, vaddr addr, int size, uintptr_t retaddr)
 {
     MemoryRegionSection *section;
     hwaddr mr_offset;
 
     section = iotlb_to_section(cpu, xlat, attrs);
     mr_offset = (xlat & TARGET_PAGE_MASK) + addr;
+    if (section->mr->subpage) {
+        section = iotlb_resolve_subpage(cpu, section, attrs, &mr_offset, size);
+    }
     cpu->mem_io_pc = retaddr;
     if (!cpu->neg.can_do_io) {
         cpu_io_recompile(cpu, retaddr);
@@ -1332,6 +1396,43 @@ static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
     return false;
 }
 
+/*
+ * Return true if [ADDR, ADDR + SIZE) lies within a sub-page translation
+ * remembered by tlb_set_page_full, and has been copied to the main tlb.
+ * The copy keeps TLB_INVALID_MASK, so the next access comes back here.
+ */
+static bool subpage_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
+                            MMUAccessType access_type, vaddr addr, int size)
+{
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
+    vaddr page = addr & TARGET_PAGE_MASK;
+    vaddr last = addr + MAX(size, 1) - 1;
+    size_t sidx;
+
+    assert_cpu_is_self(cpu);
+    for (sidx = 0; sidx < CPU_SUBPAGE_TLB_SIZE; ++sidx) {
+        CPUTLBEntry *stlb = &desc->subpage_table[sidx];
+        uint64_t cmp = tlb_read_idx(stlb, access_type);
+        vaddr mask;
+
+        if (cmp == -1 || !tlb_hit_page(cmp & ~TLB_INVALID_MASK, page)) {
+            continue;
+        }
+        mask = -((vaddr)1 << desc->subpage_fulltlb[sidx].lg_page_size);
+        if ((addr & mask) != desc->subpage_base[sidx] ||
+            (last & mask) != desc->subpage_base[sidx]) {
+            continue;
+        }
+
+        qemu_spin_lock(&cpu->neg.tlb.c.lock);
+        copy_tlb_helper_locked(&cpu->neg.tlb.f[mmu_idx].table[index], stlb);
+        qemu_spin_unlock(&cpu->neg.tlb.c.lock);
+        desc->fulltlb[index] = desc->subpage_fulltlb[sidx];
+        return true;
+    }
+    return false;
+}
+
 static void notdirty_write(CPUState *cpu, vaddr mem_vaddr, unsigned size,
                            CPUTLBEntryFull *full, uintptr_t retaddr)
 {
@@ -1345,9 +1446,12 @@ static void notdirty_write(CPUState *cpu, vaddr mem_vaddr, unsigned size,
 
     /*
      * Set both VGA and migration bits for simplicity and to remove
-     * the notdirty callback faster.
+     * the notdirty callback faster.  Blocks with sub-page dirty tracking
+     * keep the page clean for VGA, so that further stores come back here.
      */
-    cpu_physical_memory_set_dirty_range(ram_addr, size, DIRTY_CLIENTS_NOCODE);
+    cpu_physical_memory_set_dirty_range(ram_addr, size,
+        cpu_physical_memory_set_dirty_subpage(ram_addr, size,
+                                              DIRTY_CLIENTS_NOCODE));
 
     /* We remove the notdirty callback only if the code has been flushed. */
     if (!cpu_physical_memory_is_clean(ram_addr)) {
@@ -1372,24 +1476,29 @@ static int probe_access_internal(CPUState *cpu, vaddr addr,
 
     if (!tlb_hit_page(tlb_addr, page_addr)) {
         if (!victim_tlb_hit(cpu, mmu_idx, index, access_type, page_addr)) {
-            if (!tlb_fill_align(cpu, addr, access_type, mmu_idx,
-                                0, fault_size, nonfault, retaddr)) {
+            if (subpage_tlb_hit(cpu, mmu_idx, index, access_type,
+                                addr, fault_size)) {
+                /* As below: the entry is valid for this access.  */
+                flags &= ~TLB_INVALID_MASK;
+            } else if (!tlb_fill_align(cpu, addr, access_type, mmu_idx,
+                                       0, fault_size, nonfault, retaddr)) {
                 /* Non-faulting page table read failed.  */
                 *phost = NULL;
                 *pfull = NULL;
                 return TLB_INVALID_MASK;
+            } else {
+                /* TLB resize via tlb_fill_align may have moved the entry.  */
+                index = tlb_index(cpu, mmu_idx, addr);
+                entry = tlb_entry(cpu, mmu_idx, addr);
+
+                /*
+                 * With PAGE_WRITE_INV, we set TLB_INVALID_MASK immediately,
+                 * to force the next access through tlb_fill_align.  We've
+                 * just called tlb_fill_align, so we know that this entry
+                 * *is* valid.
+                 */
+                flags &= ~TLB_INVALID_MASK;
             }
-
-            /* TLB resize via tlb_fill_align may have moved the entry.  */
-            index = tlb_index(cpu, mmu_idx, addr);
-            entry = tlb_entry(cpu, mmu_idx, addr);
-
-            /*
-             * With PAGE_WRITE_INV, we set TLB_INVALID_MASK immediately,
-             * to force the next access through tlb_fill_align.  We've just
-             * called tlb_fill_align, so we know that this entry *is* valid.
-             */
-            flags &= ~TLB_INVALID_MASK;
         }
         tlb_addr = tlb_read_idx(entry, access_type);
     }
@@ -1652,7 +1761,9 @@ static bool mmu_lookup1(CPUState *cpu, MMULookupPageData *data, MemOp memop,
     /* If the TLB entry is for a different page, reload and try again.  */
     if (!tlb_hit(tlb_addr, addr)) {
         if (!victim_tlb_hit(cpu, mmu_idx, index, access_type,
-                            addr & TARGET_PAGE_MASK)) {
+                            addr & TARGET_PAGE_MASK) &&
+            !subpage_tlb_hit(cpu, mmu_idx, index, access_type,
+                             addr, data->size)) {
             tlb_fill_align(cpu, addr, access_type, mmu_idx,
                            memop, data->size, false, ra);
             maybe_resized = true;
@@ -1984,7 +2095,8 @@ static uint64_t do_ld_mmio_beN(CPUState *cpu, CPUTLBEntryFull *full,
     tcg_debug_assert(size > 0 && size <= 8);
 
     attrs = full->attrs;
-    section = io_prepare(&mr_offset, cpu, full->xlat_section, attrs, addr, ra);
+    section = io_prepare(&mr_offset, cpu, full->xlat_section, attrs,
+                         addr, size, ra);
     mr = section->mr;
 
     BQL_LOCK_GUARD();
@@ -2005,7 +2117,8 @@ static Int128 do_ld16_mmio_beN(CPUState *cpu, CPUTLBEntryFull *full,
     tcg_debug_assert(size > 8 && size <= 16);
 
     attrs = full->attrs;
-    section = io_prepare(&mr_offset, cpu, full->xlat_section, attrs, addr, ra);
+    section = io_prepare(&mr_offset, cpu, full->xlat_section, attrs,
+                         addr, size, ra);
     mr = section->mr;
 
     BQL_LOCK_GUARD();
@@ -2525,7 +2638,8 @@ static uint64_t do_st_mmio_leN(CPUState *cpu, CPUTLBEntryFull *full,
     tcg_debug_assert(size > 0 && size <= 8);
 
     attrs = full->attrs;
-    section = io_prepare(&mr_offset, cpu, full->xlat_section, attrs, addr, ra);
+    section = io_prepare(&mr_offset, cpu, full->xlat_section, attrs,
+                         addr, size, ra);
     mr = section->mr;
 
     BQL_LOCK_GUARD();
@@ -2545,7 +2659,8 @@ static uint64_t do_st16_mmio_leN(CPUState *cpu, CPUTLBEntryFull *full,
     tcg_debug_assert(size > 8 && size <= 16);
 
     attrs = full->attrs;
-    section = io_prepare(&mr_offset, cpu, full->xlat_section, attrs, addr, ra);
+    section = io_prepare(&mr_offset, cpu, full->xlat_section, attrs,
+                         addr, size, ra);
     mr = section->mr;
 
     BQL_LOCK_GUARD();
@@ -151,6 +151,7 @@ static void dump_exec_info(GString *buf)
     struct tb_tree_stats tst = {};
     struct qht_stats hst;
     size_t nb_tbs, flush_full, flush_part, flush_elide;
+    uint64_t gen_count, gen_ns;
 
     tcg_tb_foreach(tb_tree_stats_iter, &tst);
     nb_tbs = tst.nb_tbs;
@@ -192,6 +193,13 @@ static void dump_exec_info(GString *buf)
     g_string_append_printf(buf, "TB invalidate count %u\n",
                            qatomic_read(&tb_ctx.tb_phys_invalidate_count));
 
+    gen_count = stat64_get(&tb_ctx.tb_gen_count);
+    gen_ns = stat64_get(&tb_ctx.tb_gen_ns);
+    g_string_append_printf(buf, "TB translations     %" PRIu64 "\n", gen_count);
+    g_string_append_printf(buf, "translation time    %" PRIu64 " us "
+                           "(avg %" PRIu64 " ns)\n", gen_ns / 1000,
+                           gen_count ? gen_ns / gen_count : 0);
+
     tlb_flush_counts(&flush_full, &flush_part, &flush_elide);
     g_string_append_printf(buf, "TLB full flushes    %zu\n", flush_full);
     g_string_append_printf(buf, "TLB partial flushes %zu\n", flush_part);
@@ -0,0 +1,267 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Sampling guest PC profiler for TCG
+ *
+ * A host timer periodically asks every vCPU for its guest PC. The request
+ * is queued as async work, so each vCPU answers at the next TB boundary
+ * with its architectural state in sync; translated code is not
+ * instrumented at all, and the cost is one exit from the execution loop
+ * per vCPU per sample.
+ *
+ * Samples are counted per guest PC and aggregated per ELF symbol when
+ * the report is printed, using the symbols registered by the ELF loader
+ * (e.g. for a -kernel loaded through armv7m_load_kernel()).
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/lockable.h"
+#include "qemu/module.h"
+#include "qemu/timer.h"
+#include "qapi/error.h"
+#include "qapi/type-helpers.h"
+#include "qapi/qapi-commands-machine.h"
+#include "qobject/qdict.h"
+#include "monitor/hmp.h"
+#include "monitor/monitor.h"
+#include "hw/core/cpu.h"
+#include "system/runstate.h"
+#include "system/tcg.h"
+#include "disas/disas.h"
+
+#define PROFILE_DEFAULT_INTERVAL_US 1000
+#define PROFILE_MAX_INTERVAL_US 1000000
+#define PROFILE_REPORT_LINES 20
+
+typedef struct ProfileEntry {
+    uint64_t pc;        /* hash table key */
+    uint64_t count;
+    const char *name;   /* only used while building the report */
+} ProfileEntry;
+
+static struct {
+    QemuMutex lock;
+    QEMUTimer *timer;
+    int64_t interval_ns;
+    bool running;
+    /* protected by lock */
+    GHashTable *pcs;    /* guest PC -> ProfileEntry */
+    uint64_t samples;
+    uint64_t halted;
+} profiler;
+
+static void profile_sample(CPUState *cpu, run_on_cpu_data data)
+{
+    ProfileEntry *e;
+    uint64_t pc;
+
+    if (!qatomic_read(&profiler.running)) {
+        return;
+    }
+
+    pc = cpu->cc->get_pc(cpu);
+
+    QEMU_LOCK_GUARD(&profiler.lock);
+    profiler.samples++;
+    if (cpu->halted) {
+        profiler.halted++;
+        return;
+    }
+    e = g_hash_table_lookup(profiler.pcs, &pc);
+    if (!e) {
+        e = g_new0(ProfileEntry, 1);
+        e->pc = pc;
+        g_hash_table_insert(profiler.pcs, &e->pc, e);
+    }
+    e->count++;
+}
+
+static void profile_tick(void *opaque)
+{
+    CPUState *cpu;
+
+    if (runstate_is_running()) {
+        CPU_FOREACH(cpu) {
+            async_run_on_cpu(cpu, profile_sample, RUN_ON_CPU_NULL);
+        }
+    }
+    timer_mod(profiler.timer,
+              qemu_clock_get_ns(QEMU_CLOCK_REALTIME) + profiler.interval_ns);
+}
+
+void qmp_x_profile_start(bool has_interval, int64_t interval, Error **errp)
+{
+    if (!tcg_enabled()) {
+        error_setg(errp, "Profiling is only available with accel=tcg");
+        return;
+    }
+    if (profiler.running) {
+        error_setg(errp, "Profiling is already running");
+        return;
+    }
+    if (!has_interval) {
+        interval = PROFILE_DEFAULT_INTERVAL_US;
+    } else if (interval <= 0 || interval > PROFILE_MAX_INTERVAL_US) {
+        error_setg(errp, "Sampling interval must be between 1 and %d us",
+                   PROFILE_MAX_INTERVAL_US);
+        return;
+    }
+
+    WITH_QEMU_LOCK_GUARD(&profiler.lock) {
+        if (profiler.pcs) {
+            g_hash_table_remove_all(profiler.pcs);
+        } else {
+            profiler.pcs = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+                                                 NULL, g_free);
+        }
+        profiler.samples = 0;
+        profiler.halted = 0;
+    }
+
+    if (!profiler.timer) {
+        profiler.timer = timer_new_ns(QEMU_CLOCK_REALTIME, profile_tick, NULL);
+    }
+    profiler.interval_ns = interval * SCALE_US;
+    qatomic_set(&profiler.running, true);
+    timer_mod(profiler.timer,
+              qemu_clock_get_ns(QEMU_CLOCK_REALTIME) + profiler.interval_ns);
+}
+
+void qmp_x_profile_stop(Error **errp)
+{
+    if (!profiler.running) {
+        error_setg(errp, "Profiling is not running");
+        return;
+    }
+    timer_del(profiler.timer);
+    qatomic_set(&profiler.running, false);
+}
+
+static gint profile_entry_cmp(gconstpointer a, gconstpointer b)
+{
+    const ProfileEntry *x = *(ProfileEntry * const *)a;
+    const ProfileEntry *y = *(ProfileEntry * const *)b;
+
+    /* Most samples first, then by address for a stable order */
+    if (x->count != y->count) {
+        return x->count > y->count ? -1 : 1;
+    }
+    return x->pc < y->pc ? -1 : x->pc > y->pc;
+}
+
+static void profile_print_top(GString *buf, GPtrArray *entries,
+                              uint64_t total, bool by_symbol)
+{
+    guint i;
+
+    g_ptr_array_sort(entries, profile_entry_cmp);
+    for (i = 0; i < entries->len && i < PROFILE_REPORT_LINES; i++) {
+        ProfileEntry *e = g_ptr_array_index(entries, i);
+
+        g_string_append_printf(buf, "%6.2f%% %10" PRIu64 "  ",
+                               (double)e->count * 100 / total, e->count);
+        if (by_symbol) {
+            g_string_append_printf(buf, "%s\n", e->name);
+        } else {
+            g_string_append_printf(buf, "0x%08" PRIx64 " %s\n",
+                                   e->pc, e->name);
+        }
+    }
+}
+
+HumanReadableText *qmp_x_query_profile(Error **errp)
+{
+    g_autoptr(GString) buf = g_string_new("");
+    g_autoptr(GPtrArray) pcs = g_ptr_array_new_with_free_func(g_free);
+    g_autoptr(GPtrArray) syms = g_ptr_array_new();
+    g_autoptr(GHashTable) by_name = g_hash_table_new_full(g_str_hash,
+                                                          g_str_equal,
+                                                          NULL, g_free);
+    uint64_t samples, halted, active = 0;
+    GHashTableIter iter;
+    ProfileEntry *e;
+    guint i;
+
+    if (!tcg_enabled()) {
+        error_setg(errp, "Profiling is only available with accel=tcg");
+        return NULL;
+    }
+
+    /* Snapshot the counters so that vCPUs are not held up by the report */
+    WITH_QEMU_LOCK_GUARD(&profiler.lock) {
+        samples = profiler.samples;
+        halted = profiler.halted;
+        if (profiler.pcs) {
+            g_hash_table_iter_init(&iter, profiler.pcs);
+            while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&e)) {
+                g_ptr_array_add(pcs, g_memdup2(e, sizeof(*e)));
+            }
+        }
+    }
+
+    g_string_append_printf(buf, "Profiling %s, interval %" PRId64 " us\n",
+                           profiler.running ? "running" : "stopped",
+                           profiler.interval_ns / SCALE_US);
+    g_string_append_printf(buf, "Samples: %" PRIu64 " (%" PRIu64 " halted)\n",
+                           samples, halted);
+
+    for (i = 0; i < pcs->len; i++) {
+        ProfileEntry *s;
+
+        e = g_ptr_array_index(pcs, i);
+        e->name = lookup_symbol(e->pc);
+        active += e->count;
+
+        /* Addresses without a symbol are reported on their own */
+        if (!*e->name) {
+            continue;
+        }
+        s = g_hash_table_lookup(by_name, e->name);
+        if (!s) {
+            s = g_new0(ProfileEntry, 1);
+            s->name = e->name;
+            g_hash_table_insert(by_name, (gpointer)s->name, s);
+            g_ptr_array_add(syms, s);
+        }
+        s->count += e->count;
+    }
+
+    if (!active) {
+        return human_readable_text_from_str(buf);
+    }
+
+    if (syms->len) {
+        g_string_append_printf(buf, "\nTop functions:\n");
+        profile_print_top(buf, syms, active, true);
+    }
+    g_string_append_printf(buf, "\nTop addresses:\n");
+    profile_print_top(buf, pcs, active, false);
+
+    return human_readable_text_from_str(buf);
+}
+
+void hmp_profile_start(Monitor *mon, const QDict *qdict)
+{
+    Error *err = NULL;
+    bool has_interval = qdict_haskey(qdict, "interval");
+    int64_t interval = qdict_get_try_int(qdict, "interval", 0);
+
+    qmp_x_profile_start(has_interval, interval, &err);
+    hmp_handle_error(mon, err);
+}
+
+void hmp_profile_stop(Monitor *mon, const QDict *qdict)
+{
+    Error *err = NULL;
+
+    qmp_x_profile_stop(&err);
+    hmp_handle_error(mon, err);
+}
+
+static void tcg_profiler_init(void)
+{
+    qemu_mutex_init(&profiler.lock);
+    monitor_register_hmp_info_hrt("profile", qmp_x_query_profile);
+}
+
+type_init(tcg_profiler_init);
@@ -26,6 +26,7 @@
 #include "qemu/osdep.h"
 #include "system/tcg.h"
 #include "system/replay.h"
+#include "system/cpu-timers.h"
 #include "exec/icount.h"
 #include "qemu/main-loop.h"
 #include "qemu/notify.h"
@@ -114,6 +115,10 @@ static void *mttcg_cpu_thread_fn(void *arg)
         }
 
         qatomic_set_mb(&cpu->exit_request, 0);
+        if (cpu_idle_warp_enabled() && all_cpu_threads_idle()) {
+            /* Last vCPU to go idle: let the main loop warp the clock */
+            qemu_notify_event();
+        }
         qemu_wait_io_event(cpu);
     } while (!cpu->unplug || cpu_can_run(cpu));
 
@@ -27,6 +27,7 @@
 #include "qemu/lockable.h"
 #include "system/tcg.h"
 #include "system/replay.h"
+#include "system/cpu-timers.h"
 #include "exec/icount.h"
 #include "qemu/main-loop.h"
 #include "qemu/notify.h"
@@ -290,10 +291,12 @@ static void *rr_cpu_thread_fn(void *arg)
             qatomic_set_mb(&cpu->exit_request, 0);
         }
 
-        if (icount_enabled() && all_cpu_threads_idle()) {
+        if ((icount_enabled() || cpu_idle_warp_enabled()) &&
+            all_cpu_threads_idle()) {
             /*
              * When all cpus are sleeping (e.g in WFI), to avoid a deadlock
-             * in the main_loop, wake it up in order to start the warp timer.
+             * in the main_loop, wake it up in order to start the warp timer
+             * (or to warp the clock, with idle-warp).
              */
             qemu_notify_event();
         }
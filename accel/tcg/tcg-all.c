@@ -41,6 +41,7 @@
 #else
 #include "hw/boards.h"
 #include "system/tcg.h"
+#include "system/cpu-timers.h"
 #endif
 #include "accel/tcg/cpu-ops.h"
 #include "internal-common.h"
@@ -52,6 +53,7 @@ struct TCGState {
 
     OnOffAuto mttcg_enabled;
     bool one_insn_per_tb;
+    bool idle_warp;
     int splitwx_enabled;
     unsigned long tb_size;
 };
@@ -144,6 +146,8 @@ static int tcg_init_machine(MachineState *ms)
 
 #ifdef CONFIG_USER_ONLY
     qdev_create_fake_machine();
+#else
+    cpu_set_idle_warp(s->idle_warp);
 #endif
 
     return 0;
@@ -223,6 +227,26 @@ static void tcg_set_one_insn_per_tb(Object *obj, bool value, Error **errp)
     qatomic_set(&one_insn_per_tb, value);
 }
 
+#ifndef CONFIG_USER_ONLY
+static bool tcg_get_idle_warp(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->idle_warp;
+}
+
+static void tcg_set_idle_warp(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+
+    if (value && icount_enabled()) {
+        error_setg(errp, "idle-warp cannot be used with icount, "
+                   "use -icount sleep=off instead");
+        return;
+    }
+    s->idle_warp = value;
+}
+#endif /* !CONFIG_USER_ONLY */
+
 static int tcg_gdbstub_supported_sstep_flags(void)
 {
     /*
@@ -268,6 +292,14 @@ static void tcg_accel_class_init(ObjectClass *oc, const void *data)
                                    tcg_set_one_insn_per_tb);
     object_class_property_set_description(oc, "one-insn-per-tb",
         "Only put one guest insn in each translation block");
+
+#ifndef CONFIG_USER_ONLY
+    object_class_property_add_bool(oc, "idle-warp",
+                                   tcg_get_idle_warp,
+                                   tcg_set_idle_warp);
+    object_class_property_set_description(oc, "idle-warp",
+        "Skip virtual time to the next timer while all vCPUs are idle");
+#endif
 }
 
 static const TypeInfo tcg_accel_type = {
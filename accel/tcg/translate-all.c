@@ -300,11 +300,12 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     tb_page_addr_t phys_pc, phys_p2;
     tcg_insn_unit *gen_code_buf;
     int gen_code_size, search_size, max_insns;
-    int64_t ti;
+    int64_t ti, start;
     void *host_pc;
 
     assert_memory_lock();
     qemu_thread_jit_write();
+    start = get_clock();
 
     phys_pc = get_page_addr_code_hostp(env, pc, &host_pc);
 
@@ -430,6 +431,8 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
         goto buffer_overflow;
     }
     tb->tc.size = gen_code_size;
+    stat64_add(&tb_ctx.tb_gen_count, 1);
+    stat64_add(&tb_ctx.tb_gen_ns, get_clock() - start);
 
     /*
      * For CF_PCREL, attribute all executions of the generated code
@@ -270,6 +270,21 @@ SRST
     Show dynamic compiler opcode counters
 ERST
 
+#if defined(CONFIG_TCG)
+    {
+        .name       = "profile",
+        .args_type  = "",
+        .params     = "",
+        .help       = "show the samples collected by profile_start",
+    },
+#endif
+
+SRST
+  ``info profile``
+    Show the guest PC samples collected since ``profile_start``, per
+    symbol and per address.
+ERST
+
     {
         .name       = "sync-profile",
         .args_type  = "mean:-m,no_coalesce:-n,max:i?",
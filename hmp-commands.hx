@@ -268,6 +268,35 @@ SRST
 ``screendump`` *filename*
   Save screen into PPM image *filename*.
 ERST
+
+    {
+        .name       = "screen_record_start",
+        .args_type  = "interval:-is,filename:F,device:s?,head:i?",
+        .params     = "[-i interval] filename [device [head]]",
+        .help       = "record the damaged areas of head 'head' of display "
+                      "device 'device' to 'filename', sampling every "
+                      "'interval' ms of virtual time (default 40)",
+        .cmd        = hmp_screen_record_start,
+    },
+
+SRST
+``screen_record_start`` [-i *interval*] *filename* [*device* [*head*]]
+  Start recording the screen into *filename*, sampling the changed
+  areas every *interval* milliseconds of virtual time.
+ERST
+
+    {
+        .name       = "screen_record_stop",
+        .args_type  = "",
+        .params     = "",
+        .help       = "stop the screen recording",
+        .cmd        = hmp_screen_record_stop,
+    },
+
+SRST
+``screen_record_stop``
+  Stop the screen recording started with ``screen_record_start``.
+ERST
 #endif
 
     {
@@ -639,6 +668,36 @@ SRST
   whether profiling is on or off.
 ERST
 
+#if defined(CONFIG_TCG)
+    {
+        .name       = "profile_start",
+        .args_type  = "interval:i?",
+        .params     = "[interval]",
+        .help       = "start sampling the guest PC of every vCPU every "
+                      "'interval' us of host time (default 1000)",
+        .cmd        = hmp_profile_start,
+    },
+
+SRST
+``profile_start`` [*interval*]
+  Start sampling the guest PC of every vCPU every *interval*
+  microseconds. Use ``info profile`` to see the results.
+ERST
+
+    {
+        .name       = "profile_stop",
+        .args_type  = "",
+        .params     = "",
+        .help       = "stop sampling the guest PC",
+        .cmd        = hmp_profile_stop,
+    },
+
+SRST
+``profile_stop``
+  Stop the sampling started with ``profile_start``.
+ERST
+#endif
+
     {
         .name       = "system_reset",
         .args_type  = "",
@@ -34,6 +34,28 @@ static inline hwaddr bitband_addr(BitBandState *s, hwaddr offset)
     return s->base | (offset & 0x1ffffff) >> 5;
 }
 
+/*
+ * If the byte at @addr is RAM, return a host pointer to it and its
+ * region and offset in @pmr and @pxlat.  Otherwise return NULL and the
+ * caller must go through the memory API.  The caller must hold the RCU
+ * read lock for as long as it uses the pointer.
+ */
+static uint8_t *bitband_ram_ptr(BitBandState *s, hwaddr addr, bool is_write,
+                                MemTxAttrs attrs, MemoryRegion **pmr,
+                                hwaddr *pxlat)
+{
+    MemoryRegion *mr;
+    hwaddr len = 1;
+
+    mr = address_space_translate(&s->source_as, addr, pxlat, &len,
+                                 is_write, attrs);
+    if (!memory_access_is_direct(mr, is_write, attrs)) {
+        return NULL;
+    }
+    *pmr = mr;
+    return qemu_map_ram_ptr(mr->ram_block, *pxlat);
+}
+
 static MemTxResult bitband_read(void *opaque, hwaddr offset,
                                 uint64_t *data, unsigned size, MemTxAttrs attrs)
 {
@@ -41,10 +63,22 @@ static MemTxResult bitband_read(void *opaque, hwaddr offset,
     uint8_t buf[4];
     MemTxResult res;
     int bitpos, bit;
-    hwaddr addr;
+    hwaddr addr, xlat;
+    MemoryRegion *mr;
+    uint8_t *ptr;
 
     assert(size <= 4);
 
+    /* Fast path: test the bit directly in host RAM */
+    WITH_RCU_READ_LOCK_GUARD() {
+        ptr = bitband_ram_ptr(s, bitband_addr(s, offset), false, attrs,
+                              &mr, &xlat);
+        if (ptr) {
+            *data = (qatomic_read(ptr) >> ((offset >> 2) & 7)) & 1;
+            return MEMTX_OK;
+        }
+    }
+
     /* Find address in underlying memory and round down to multiple of size */
     addr = bitband_addr(s, offset) & (-size);
     res = address_space_read(&s->source_as, addr, attrs, buf, size);
@@ -66,10 +100,31 @@ static MemTxResult bitband_write(void *opaque, hwaddr offset, uint64_t value,
     uint8_t buf[4];
     MemTxResult res;
     int bitpos, bit;
-    hwaddr addr;
+    hwaddr addr, xlat;
+    MemoryRegion *mr;
+    uint8_t *ptr;
 
     assert(size <= 4);
 
+    /*
+     * Fast path: update the bit in host RAM with a single atomic operation,
+     * which also keeps it atomic against other vCPUs writing the same byte.
+     */
+    WITH_RCU_READ_LOCK_GUARD() {
+        ptr = bitband_ram_ptr(s, bitband_addr(s, offset), true, attrs,
+                              &mr, &xlat);
+        if (ptr) {
+            bit = 1 << ((offset >> 2) & 7);
+            if (value & 1) {
+                qatomic_or(ptr, bit);
+            } else {
+                qatomic_and(ptr, ~bit);
+            }
+            memory_region_flush_ram(mr, xlat, 1);
+            return MEMTX_OK;
+        }
+    }
+
     /* Find address in underlying memory and round down to multiple of size */
     addr = bitband_addr(s, offset) & (-size);
     res = address_space_read(&s->source_as, addr, attrs, buf, size);
@@ -387,7 +442,7 @@ static void armv7m_realize(DeviceState *dev, Error **errp)
      * banked version of all of these.
      *
      * The default behaviour for unimplemented registers/ranges
-     * (for instance the Data Watchpoint and Trace unit at 0xe0001000)
+     * (for instance the Instrumentation Trace Macrocell at 0xe0000000)
      * is to RAZ/WI for privileged access and BusFault for non-privileged
      * access.
      *
@@ -515,6 +570,19 @@ static void armv7m_realize(DeviceState *dev, Error **errp)
                                             sysbus_mmio_get_region(sbd, 0), 1);
     }
 
+    /* Main Extension CPUs have a DWT with a cycle counter */
+    if (arm_feature(&s->cpu->env, ARM_FEATURE_M_MAIN)) {
+        object_initialize_child(OBJECT(dev), "armv7m-dwt",
+                                &s->dwt, TYPE_ARMV7M_DWT);
+        qdev_connect_clock_in(DEVICE(&s->dwt), "cpuclk", s->cpuclk);
+        sbd = SYS_BUS_DEVICE(&s->dwt);
+        if (!sysbus_realize(sbd, errp)) {
+            return;
+        }
+        memory_region_add_subregion_overlap(&s->container, 0xe0001000,
+                                            sysbus_mmio_get_region(sbd, 0), 1);
+    }
+
     for (i = 0; i < ARRAY_SIZE(s->bitband); i++) {
         if (s->enable_bitband) {
             Object *obj = OBJECT(&s->bitband[i]);
@@ -589,6 +657,23 @@ static void armv7m_reset(void *opaque)
     cpu_reset(CPU(cpu));
 }
 
+/* Record the kernel's memcpy and memset entry points, for cpu->bulk_mem */
+static void armv7m_kernel_symbol(const char *st_name, int st_info,
+                                 uint64_t st_value, uint64_t st_size,
+                                 void *opaque)
+{
+    ARMCPU *cpu = opaque;
+
+    if (ELF_ST_TYPE(st_info) != STT_FUNC) {
+        return;
+    }
+    if (!strcmp(st_name, "memcpy")) {
+        cpu->bulk_memcpy_addr = st_value & ~1ULL;
+    } else if (!strcmp(st_name, "memset")) {
+        cpu->bulk_memset_addr = st_value & ~1ULL;
+    }
+}
+
 void armv7m_load_kernel(ARMCPU *cpu, const char *kernel_filename,
                         hwaddr mem_base, int mem_size)
 {
@@ -606,10 +691,15 @@ void armv7m_load_kernel(ARMCPU *cpu, const char *kernel_filename,
     as = cpu_get_address_space(cs, asidx);
 
     if (kernel_filename) {
-        image_size = load_elf_as(kernel_filename, NULL, NULL, NULL,
-                                 &entry, NULL, NULL,
-                                 NULL, ELFDATA2LSB, EM_ARM, 1, 0, as);
+        image_size = load_elf_ram_sym(kernel_filename, NULL, NULL, NULL,
+                                      &entry, NULL, NULL,
+                                      NULL, ELFDATA2LSB, EM_ARM, 1, 0, as,
+                                      true,
+                                      cpu->bulk_mem ? armv7m_kernel_symbol
+                                                    : NULL,
+                                      cpu);
         if (image_size < 0) {
+            cpu->bulk_memcpy_addr = cpu->bulk_memset_addr = 0;
             image_size = load_image_targphys_as(kernel_filename, mem_base,
                                                 mem_size, as);
         }
@@ -57,6 +57,7 @@
 #include "system/address-spaces.h"
 #include "system/system.h"
 #include "system/reset.h"
+#include "system/hostmem.h"
 #include "hw/misc/unimp.h"
 #include "hw/char/cmsdk-apb-uart.h"
 #include "hw/timer/cmsdk-apb-timer.h"
@@ -139,6 +140,8 @@ struct MPS2TZMachineState {
 
     ARMSSE iotkit;
     MemoryRegion ram[MPS2TZ_RAM_MAX];
+    /* Optional user-supplied backends for ram[], by RAMInfo mrindex */
+    HostMemoryBackend *memdev[MPS2TZ_RAM_MAX];
     MemoryRegion eth_usb_container;
 
     MPS2SCC scc;
@@ -337,8 +340,8 @@ static MemoryRegion *mr_for_raminfo(MPS2TZMachineState *mms,
     assert(raminfo->mrindex < MPS2TZ_RAM_MAX);
     ram = &mms->ram[raminfo->mrindex];
 
-    memory_region_init_ram(ram, NULL, raminfo->name,
-                           raminfo->size, &error_fatal);
+    ram = machine_init_board_ram(MACHINE(mms), mms->memdev[raminfo->mrindex],
+                                 ram, raminfo->name, raminfo->size);
     if (raminfo->flags & IS_ROM) {
         memory_region_set_readonly(ram, true);
     }
@@ -1288,11 +1291,38 @@ static void mps2tz_set_default_ram_info(MPS2TZMachineClass *mmc)
 {
     /*
      * Set mc->default_ram_size and default_ram_id from the
-     * information in mmc->raminfo.
+     * information in mmc->raminfo, and add the memory backend
+     * properties for the other RAMs it describes.
      */
     MachineClass *mc = MACHINE_CLASS(mmc);
     const RAMInfo *p;
 
+    /*
+     * Let the user supply a memory backend for each RAM we create
+     * ourselves, as "<ram name>-memdev" (eg "ssram-0-memdev").
+     */
+    for (p = mmc->raminfo; p->name; p++) {
+        g_autofree char *lname = NULL;
+        g_autofree char *propname = NULL;
+        g_autofree char *desc = NULL;
+
+        if (p->mrindex < 0 || (p->flags & IS_ALIAS)) {
+            continue;
+        }
+        lname = g_strdelimit(g_ascii_strdown(p->name, -1), " ", '-');
+        propname = g_strdup_printf("%s-memdev", lname);
+        desc = g_strdup_printf("Memory backend for the %s %s", p->name,
+                               (p->flags & IS_ROM) ? "ROM" : "RAM");
+        object_class_property_add_link(OBJECT_CLASS(mmc), propname,
+                                       TYPE_MEMORY_BACKEND,
+                                       offsetof(MPS2TZMachineState, memdev) +
+                                       p->mrindex * sizeof(HostMemoryBackend *),
+                                       object_property_allow_set_link,
+                                       OBJ_PROP_LINK_STRONG);
+        object_class_property_set_description(OBJECT_CLASS(mmc), propname,
+                                              desc);
+    }
+
     for (p = mmc->raminfo; p->name; p++) {
         if (p->mrindex < 0) {
             /* Found the entry for "system memory" */
@@ -35,6 +35,7 @@
 #include "hw/boards.h"
 #include "system/address-spaces.h"
 #include "system/system.h"
+#include "system/hostmem.h"
 #include "hw/qdev-properties.h"
 #include "hw/misc/unimp.h"
 #include "hw/char/cmsdk-apb-uart.h"
@@ -83,6 +84,11 @@ struct MPS2MachineState {
     MemoryRegion blockram_m2;
     MemoryRegion blockram_m3;
     MemoryRegion sram;
+    /* Optional user-supplied backends for the RAMs above */
+    HostMemoryBackend *ssram1_memdev;
+    HostMemoryBackend *ssram23_memdev;
+    HostMemoryBackend *blockram_memdev;
+    HostMemoryBackend *sram_memdev;
     /* FPGA APB subsystem */
     MPS2SCC scc;
     MPS2FPGAIO fpgaio;
@@ -116,13 +122,17 @@ OBJECT_DECLARE_TYPE(MPS2MachineState, MPS2MachineClass, MPS2_MACHINE)
 #define REFCLK_FRQ (1 * 1000 * 1000)
 
 /* Initialize the auxiliary RAM region @mr and map it into
- * the memory map at @base.
+ * the memory map at @base. If the user gave a memory backend
+ * @memdev for it, map the backend's region instead. Returns
+ * the region that was mapped.
  */
-static void make_ram(MemoryRegion *mr, const char *name,
-                     hwaddr base, hwaddr size)
+static MemoryRegion *make_ram(MachineState *machine, MemoryRegion *mr,
+                              HostMemoryBackend *memdev, const char *name,
+                              hwaddr base, hwaddr size)
 {
-    memory_region_init_ram(mr, NULL, name, size, &error_fatal);
+    mr = machine_init_board_ram(machine, memdev, mr, name, size);
     memory_region_add_subregion(get_system_memory(), base, mr);
+    return mr;
 }
 
 /* Create an alias of an entire original MemoryRegion @orig
@@ -168,6 +178,7 @@ static void mps2_common_init(MachineState *machine)
     MPS2MachineClass *mmc = MPS2_MACHINE_GET_CLASS(machine);
     MemoryRegion *system_memory = get_system_memory();
     MachineClass *mc = MACHINE_GET_CLASS(machine);
+    MemoryRegion *ram;
     DeviceState *armv7m, *sccdev;
     QList *oscclk;
     int i;
@@ -220,35 +231,49 @@ static void mps2_common_init(MachineState *machine)
     memory_region_add_subregion(system_memory, mmc->psram_base, machine->ram);
 
     if (mmc->has_block_ram) {
-        make_ram(&mms->blockram, "mps.blockram", 0x01000000, 0x4000);
-        make_ram_alias(&mms->blockram_m1, "mps.blockram_m1",
-                       &mms->blockram, 0x01004000);
-        make_ram_alias(&mms->blockram_m2, "mps.blockram_m2",
-                       &mms->blockram, 0x01008000);
-        make_ram_alias(&mms->blockram_m3, "mps.blockram_m3",
-                       &mms->blockram, 0x0100c000);
+        ram = make_ram(machine, &mms->blockram, mms->blockram_memdev,
+                       "mps.blockram", 0x01000000, 0x4000);
+        make_ram_alias(&mms->blockram_m1, "mps.blockram_m1", ram, 0x01004000);
+        make_ram_alias(&mms->blockram_m2, "mps.blockram_m2", ram, 0x01008000);
+        make_ram_alias(&mms->blockram_m3, "mps.blockram_m3", ram, 0x0100c000);
     }
 
     switch (mmc->fpga_type) {
     case FPGA_AN385:
     case FPGA_AN386:
     case FPGA_AN500:
-        make_ram(&mms->ssram1, "mps.ssram1", 0x0, 0x400000);
-        make_ram_alias(&mms->ssram1_m, "mps.ssram1_m", &mms->ssram1, 0x400000);
-        make_ram(&mms->ssram23, "mps.ssram23", 0x20000000, 0x400000);
-        make_ram_alias(&mms->ssram23_m, "mps.ssram23_m",
-                       &mms->ssram23, 0x20400000);
+        ram = make_ram(machine, &mms->ssram1, mms->ssram1_memdev,
+                       "mps.ssram1", 0x0, 0x400000);
+        make_ram_alias(&mms->ssram1_m, "mps.ssram1_m", ram, 0x400000);
+        ram = make_ram(machine, &mms->ssram23, mms->ssram23_memdev,
+                       "mps.ssram23", 0x20000000, 0x400000);
+        make_ram_alias(&mms->ssram23_m, "mps.ssram23_m", ram, 0x20400000);
         break;
     case FPGA_AN511:
-        make_ram(&mms->blockram, "mps.blockram", 0x0, 0x40000);
-        make_ram(&mms->ssram1, "mps.ssram1", 0x00400000, 0x00800000);
-        make_ram(&mms->sram, "mps.sram", 0x20000000, 0x20000);
-        make_ram(&mms->ssram23, "mps.ssram23", 0x20400000, 0x400000);
+        make_ram(machine, &mms->blockram, mms->blockram_memdev,
+                 "mps.blockram", 0x0, 0x40000);
+        make_ram(machine, &mms->ssram1, mms->ssram1_memdev,
+                 "mps.ssram1", 0x00400000, 0x00800000);
+        make_ram(machine, &mms->sram, mms->sram_memdev,
+                 "mps.sram", 0x20000000, 0x20000);
+        make_ram(machine, &mms->ssram23, mms->ssram23_memdev,
+                 "mps.ssram23", 0x20400000, 0x400000);
         break;
     default:
         g_assert_not_reached();
     }
 
+    /* Reject backends for RAMs that this board doesn't have */
+    if (mms->blockram_memdev &&
+        !host_memory_backend_is_mapped(mms->blockram_memdev)) {
+        error_report("This board has no block RAM for blockram-memdev");
+        exit(EXIT_FAILURE);
+    }
+    if (mms->sram_memdev && !host_memory_backend_is_mapped(mms->sram_memdev)) {
+        error_report("This board has no SRAM for sram-memdev");
+        exit(EXIT_FAILURE);
+    }
+
     object_initialize_child(OBJECT(mms), "armv7m", &mms->armv7m, TYPE_ARMV7M);
     armv7m = DEVICE(&mms->armv7m);
     switch (mmc->fpga_type) {
@@ -507,6 +532,17 @@ static void mps2_common_init(MachineState *machine)
                        0, 0x400000);
 }
 
+static void mps2_add_memdev_prop(ObjectClass *oc, const char *name,
+                                 ptrdiff_t offset, const char *ram)
+{
+    g_autofree char *desc = g_strdup_printf("Memory backend for the %s", ram);
+
+    object_class_property_add_link(oc, name, TYPE_MEMORY_BACKEND, offset,
+                                   object_property_allow_set_link,
+                                   OBJ_PROP_LINK_STRONG);
+    object_class_property_set_description(oc, name, desc);
+}
+
 static void mps2_class_init(ObjectClass *oc, const void *data)
 {
     MachineClass *mc = MACHINE_CLASS(oc);
@@ -517,6 +553,19 @@ static void mps2_class_init(ObjectClass *oc, const void *data)
     mc->max_cpus = 1;
     mc->default_ram_size = 16 * MiB;
     mc->default_ram_id = "mps.ram";
+
+    mps2_add_memdev_prop(oc, "ssram1-memdev",
+                         offsetof(MPS2MachineState, ssram1_memdev),
+                         "ZBT SSRAM1");
+    mps2_add_memdev_prop(oc, "ssram23-memdev",
+                         offsetof(MPS2MachineState, ssram23_memdev),
+                         "ZBT SSRAM 2&3");
+    mps2_add_memdev_prop(oc, "blockram-memdev",
+                         offsetof(MPS2MachineState, blockram_memdev),
+                         "FPGA block RAM");
+    mps2_add_memdev_prop(oc, "sram-memdev",
+                         offsetof(MPS2MachineState, sram_memdev),
+                         "SRAM (AN511 only)");
 }
 
 static void mps2_an385_class_init(ObjectClass *oc, const void *data)
@@ -431,7 +431,7 @@ ssize_t load_elf_as(const char *filename,
                             translate_fn, translate_opaque,
                             pentry, lowaddr, highaddr, pflags, elf_data_order,
                             elf_machine, clear_lsb, data_swab, as,
-                            true, NULL);
+                            true, NULL, NULL);
 }
 
 /* return < 0 if error, otherwise the number of bytes loaded in memory */
@@ -442,7 +442,8 @@ ssize_t load_elf_ram_sym(const char *filename,
                          uint64_t *lowaddr, uint64_t *highaddr,
                          uint32_t *pflags, int elf_data_order, int elf_machine,
                          int clear_lsb, int data_swab,
-                         AddressSpace *as, bool load_rom, symbol_fn_t sym_cb)
+                         AddressSpace *as, bool load_rom, symbol_fn_t sym_cb,
+                         void *sym_opaque)
 {
     const int host_data_order = HOST_BIG_ENDIAN ? ELFDATA2MSB : ELFDATA2LSB;
     int fd, must_swab;
@@ -476,12 +477,14 @@ ssize_t load_elf_ram_sym(const char *filename,
         ret = load_elf64(filename, fd, elf_note_fn,
                          translate_fn, translate_opaque, must_swab,
                          pentry, lowaddr, highaddr, pflags, elf_machine,
-                         clear_lsb, data_swab, as, load_rom, sym_cb);
+                         clear_lsb, data_swab, as, load_rom, sym_cb,
+                         sym_opaque);
     } else {
         ret = load_elf32(filename, fd, elf_note_fn,
                          translate_fn, translate_opaque, must_swab,
                          pentry, lowaddr, highaddr, pflags, elf_machine,
-                         clear_lsb, data_swab, as, load_rom, sym_cb);
+                         clear_lsb, data_swab, as, load_rom, sym_cb,
+                         sym_opaque);
     }
 
     if (ret > 0) {
@@ -954,7 +957,7 @@ static QTAILQ_HEAD(, Rom) roms = QTAILQ_HEAD_INITIALIZER(roms);
 
 /*
  * rom->data can be heap-allocated or memory-mapped (e.g. when added with
- * rom_add_elf_program())
+ * rom_add_file() or rom_add_elf_program())
  */
 static void rom_free_data(Rom *rom)
 {
@@ -1047,6 +1050,7 @@ ssize_t rom_add_file(const char *file, const char *fw_dir,
     gsize size;
     g_autoptr(GError) gerr = NULL;
     char devpath[100];
+    int fd;
 
     if (as && mr) {
         fprintf(stderr, "Specifying an Address Space and Memory Region is " \
@@ -1063,8 +1067,26 @@ ssize_t rom_add_file(const char *file, const char *fw_dir,
         rom->path = g_strdup(file);
     }
 
-    if (!g_file_get_contents(rom->path, (gchar **) &rom->data,
-                             &size, &gerr)) {
+    /*
+     * Map the file privately rather than reading it into a buffer: its
+     * pages stay shared with the host page cache, and so with any other
+     * QEMU using the same image, until they are written to. Fall back
+     * to reading it for files which can't be mapped.
+     *
+     * The file is opened read-only, so that images the user can't write
+     * to can still be mapped; 'writable' only makes the private copy of
+     * the mapping writable, and changes are never written back.
+     */
+    fd = open(rom->path, O_RDONLY | O_BINARY);
+    if (fd >= 0) {
+        rom->mapped_file = g_mapped_file_new_from_fd(fd, true, NULL);
+        close(fd);
+    }
+    if (rom->mapped_file) {
+        rom->data = (uint8_t *)g_mapped_file_get_contents(rom->mapped_file);
+        size = g_mapped_file_get_length(rom->mapped_file);
+    } else if (!g_file_get_contents(rom->path, (gchar **) &rom->data,
+                                    &size, &gerr)) {
         fprintf(stderr, "rom: file %-20s: error %s\n",
                 rom->name, gerr->message);
         goto err;
@@ -12,6 +12,7 @@
 
 #include "qemu/osdep.h"
 #include "qemu/units.h"
+#include "qemu/cutils.h"
 #include "qemu/accel.h"
 #include "system/replay.h"
 #include "hw/boards.h"
@@ -1532,6 +1533,26 @@ MemoryRegion *machine_consume_memdev(MachineState *machine,
     return ret;
 }
 
+MemoryRegion *machine_init_board_ram(MachineState *machine,
+                                     HostMemoryBackend *backend,
+                                     MemoryRegion *mr, const char *name,
+                                     uint64_t size)
+{
+    if (!backend) {
+        memory_region_init_ram(mr, NULL, name, size, &error_fatal);
+        return mr;
+    }
+
+    if (memory_region_size(host_memory_backend_get_memory(backend)) != size) {
+        char *sz = size_to_str(size);
+        error_report("Memory backend for %s has the wrong size, "
+                     "should be %s", name, sz);
+        g_free(sz);
+        exit(EXIT_FAILURE);
+    }
+    return machine_consume_memdev(machine, backend);
+}
+
 const char *machine_class_default_cpu_type(MachineClass *mc)
 {
     if (mc->valid_cpu_types && !mc->valid_cpu_types[1]) {
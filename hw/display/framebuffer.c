@@ -66,13 +66,17 @@ void framebuffer_update_display(
     int *first_row, /* Input and output.  */
     int *last_row /* Output only */)
 {
-    DirtyBitmapSnapshot *snap;
+    /*
+     * Display updates run under the BQL, so one snapshot buffer can be
+     * shared by every framebuffer; it only grows to fit the largest one.
+     */
+    static DirtyBitmapSnapshot *snap;
     uint8_t *dest;
     uint8_t *src;
     int first, last = 0;
-    int dirty;
     int i;
-    ram_addr_t addr;
+    ram_addr_t addr, end;
+    hwaddr span_start = 0, span_end = 0;
     MemoryRegion *mem;
 
     i = *first_row;
@@ -99,21 +103,36 @@ void framebuffer_update_display(
     src += i * src_width;
     dest += i * dest_row_pitch;
 
-    snap = memory_region_snapshot_and_clear_dirty(mem, addr, src_width * rows,
-                                                  DIRTY_MEMORY_VGA);
+    end = addr + (rows - i) * src_width;
+    snap = memory_region_snapshot_and_clear_dirty_reuse(mem, addr,
+                                                        end - addr,
+                                                        DIRTY_MEMORY_VGA,
+                                                        snap);
     for (; i < rows; i++) {
-        dirty = memory_region_snapshot_get_dirty(mem, snap, addr, src_width);
-        if (dirty || invalidate) {
-            fn(opaque, dest, src, cols, dest_col_pitch);
-            if (first == -1)
-                first = i;
-            last = i;
+        if (!invalidate) {
+            /* Find the next dirty span, skipping clean lines before it */
+            if (span_end <= addr &&
+                !memory_region_snapshot_next_dirty(mem, snap, addr, end,
+                                                   &span_start, &span_end)) {
+                break;
+            }
+            if (span_start >= addr + src_width) {
+                int skip = (span_start - addr) / src_width;
+
+                i += skip;
+                addr += (ram_addr_t)skip * src_width;
+                src += (ptrdiff_t)skip * src_width;
+                dest += (ptrdiff_t)skip * dest_row_pitch;
+            }
         }
+        fn(opaque, dest, src, cols, dest_col_pitch);
+        if (first == -1)
+            first = i;
+        last = i;
         addr += src_width;
         src += src_width;
         dest += dest_row_pitch;
     }
-    g_free(snap);
     if (first < 0) {
         return;
     }
@@ -35,6 +35,7 @@
 #include "hw/sysbus.h"
 #include "hw/registerfields.h"
 #include "hw/irq.h"
+#include "trace.h"
 
 #define TYPE_MPS2FB "mps2-fb"
 OBJECT_DECLARE_SIMPLE_TYPE(MPS2FBState, MPS2FB)
@@ -102,6 +103,8 @@ struct MPS2FBState {
 
     uint32_t cols;
     uint32_t rows;
+    uint32_t dirty_granularity;
+    uint32_t dirty_hold;
     int invalidate;
 
     /* Touch state */
@@ -120,6 +123,14 @@ struct MPS2FBState {
 static const Property mps2fb_properties[] = {
     DEFINE_PROP_UINT32("cols", MPS2FBState, cols, 640),
     DEFINE_PROP_UINT32("rows", MPS2FBState, rows, 480),
+    /* Bytes per dirty tracking block; 0 tracks whole pages */
+    DEFINE_PROP_UINT32("dirty-granularity", MPS2FBState, dirty_granularity,
+                       256),
+    /*
+     * Refreshes a dirty page is redrawn for before stores trap again;
+     * 0 disables it, since held pages are redrawn even if not rewritten
+     */
+    DEFINE_PROP_UINT32("dirty-hold", MPS2FBState, dirty_hold, 0),
 };
 
 static void mps2fb_update_irq(MPS2FBState *s)
@@ -231,20 +242,23 @@ static void mps2fb_update(void *opaque)
     int src_width = s->cols * bytes_per_pixel;
     int dest_width = src_width;
     int first = 0, last = 0;
+    int invalidate = s->invalidate;
     DisplaySurface *surface = qemu_console_surface(s->con);
 
     if (s->invalidate) {
         framebuffer_update_memory_section(&s->fbsection, &s->fb_mr, 0,
-                                         s->cols * bytes_per_pixel,
-                                         s->rows);
+                                          s->rows, src_width);
         s->invalidate = 0;
     }
 
     framebuffer_update_display(surface, &s->fbsection, s->cols, s->rows,
-                               src_width, dest_width, 0, 1, mps2fb_draw_line,
-                               s, &first, &last);
+                               src_width, dest_width, 0, invalidate,
+                               mps2fb_draw_line, s, &first, &last);
 
-    dpy_gfx_update(s->con, 0, 0, s->cols, s->rows);
+    /* Only report the rows the guest touched, listeners rely on it */
+    if (first >= 0) {
+        dpy_gfx_update(s->con, 0, first, s->cols, last - first + 1);
+    }
 }
 
 static void mps2fb_invalidate(void *opaque)
@@ -366,12 +380,74 @@ static void mps2fb_touch_event(DeviceState *dev,
     }
 }
 
+static uint32_t mps2fb_scale(int value, uint32_t range)
+{
+    value = MAX(value, 0);
+    value = MIN(value, INPUT_EVENT_ABS_MAX - 1);
+    return ((uint64_t)value * range) / INPUT_EVENT_ABS_MAX;
+}
+
+/*
+ * Batched variant of mps2fb_touch_event(): the whole point is updated
+ * at once, so the guest gets a single interrupt per pointer update
+ * instead of one per axis and never sees a half-updated position.
+ */
+static void mps2fb_touch_pointer(DeviceState *dev,
+                                 QemuConsole *con,
+                                 const QemuInputPointer *ptr)
+{
+    MPS2FBState *s = MPS2FB(dev);
+    MPS2FBTouchPoint *point;
+    uint32_t x, y, pressed;
+    int32_t track_id;
+    int i;
+
+    if (ptr->slot == INPUT_POINTER_SLOT_MOUSE) {
+        i = MOUSE_SLOT;
+        pressed = !!(ptr->buttons & (1u << INPUT_BUTTON_LEFT));
+        track_id = pressed ? 0 : -1;
+    } else {
+        i = ptr->slot + MULTI_TOUCH_SLOT_OFFSET;
+        if (i < 0 || i >= MAX_TOUCH_POINTS) {
+            return;
+        }
+        pressed = ptr->type != INPUT_MULTI_TOUCH_TYPE_END &&
+                  ptr->type != INPUT_MULTI_TOUCH_TYPE_CANCEL;
+        track_id = pressed ? ptr->tracking_id : -1;
+    }
+
+    point = &s->touch_points[i];
+    x = pressed || ptr->slot == INPUT_POINTER_SLOT_MOUSE ?
+        mps2fb_scale(ptr->x, s->cols) : point->x;
+    y = pressed || ptr->slot == INPUT_POINTER_SLOT_MOUSE ?
+        mps2fb_scale(ptr->y, s->rows) : point->y;
+
+    if (point->x == x && point->y == y && point->pressed == pressed &&
+        point->track_id == track_id) {
+        return;
+    }
+
+    point->x = x;
+    point->y = y;
+    point->pressed = pressed;
+    point->track_id = track_id;
+    if (pressed) {
+        s->touch_header.points_mask |= (1 << i);
+    } else {
+        s->touch_header.points_mask &= ~(1 << i);
+    }
+
+    trace_mps2fb_touch(i, x, y, pressed);
+    mps2fb_update_irq(s);
+}
+
 // Define the input handlers for our console
 
 static const QemuInputHandler mps2_touch_handler = {
     .name  = "mps2-touchscreen",
     .mask  = INPUT_EVENT_MASK_BTN | INPUT_EVENT_MASK_ABS | INPUT_EVENT_MASK_MTT,
     .event = mps2fb_touch_event,
+    .pointer = mps2fb_touch_pointer,
 };
 
 static void mps2fb_realize(DeviceState *dev, Error **errp)
@@ -381,6 +457,10 @@ static void mps2fb_realize(DeviceState *dev, Error **errp)
 
     /* Initialize framebuffer memory */
     memory_region_init_ram(&s->fb_mr, OBJECT(dev), "mps2-fb", fb_size, errp);
+    if (s->dirty_granularity) {
+        memory_region_set_dirty_granularity(&s->fb_mr, s->dirty_granularity);
+    }
+    memory_region_set_dirty_hold(&s->fb_mr, s->dirty_hold);
 
     /* Initialize control region */
     memory_region_init_io(&s->control_mr, OBJECT(dev), &control_region_ops, s,
@@ -88,6 +88,59 @@ static int nvic_pending_prio(NVICState *s)
     return s->vectpending_prio;
 }
 
+/*
+ * Update the pending_irqs and live_irqs bitmaps after the state of
+ * exception @irq in vectors[] has changed. Internal exceptions are
+ * not tracked there, because the scans always look at all of them.
+ */
+static void nvic_irq_state_changed(NVICState *s, int irq)
+{
+    VecInfo *vec;
+
+    if (irq < NVIC_FIRST_IRQ) {
+        return;
+    }
+
+    vec = &s->vectors[irq];
+    if (vec->pending) {
+        set_bit(irq, s->pending_irqs);
+    } else {
+        clear_bit(irq, s->pending_irqs);
+    }
+    if ((vec->enabled && vec->pending) || vec->active) {
+        set_bit(irq, s->live_irqs);
+    } else {
+        clear_bit(irq, s->live_irqs);
+    }
+}
+
+/* Recalculate pending_irqs and live_irqs from scratch */
+static void nvic_rebuild_irq_state(NVICState *s)
+{
+    int irq;
+
+    bitmap_zero(s->pending_irqs, NVIC_MAX_VECTORS);
+    bitmap_zero(s->live_irqs, NVIC_MAX_VECTORS);
+    for (irq = NVIC_FIRST_IRQ; irq < s->num_irq; irq++) {
+        nvic_irq_state_changed(s, irq);
+    }
+}
+
+/*
+ * Return the first exception number >= @irq that can be enabled and
+ * pending or active, or s->num_irq if there is none. Every internal
+ * exception qualifies; external interrupts are looked up in live_irqs,
+ * so loops using this skip idle interrupts a word at a time while still
+ * visiting exceptions in increasing number order.
+ */
+static int nvic_next_live_irq(NVICState *s, int irq)
+{
+    if (irq < NVIC_FIRST_IRQ) {
+        return irq;
+    }
+    return find_next_bit(s->live_irqs, s->num_irq, irq);
+}
+
 /* Return the value of the ISCR RETTOBASE bit:
  * 1 if there is exactly one active exception
  * 0 if there is more than one active exception
@@ -107,7 +160,8 @@ static bool nvic_rettobase(NVICState *s)
     int irq, nhand = 0;
     bool check_sec = arm_feature(&s->cpu->env, ARM_FEATURE_M_SECURITY);
 
-    for (irq = ARMV7M_EXCP_RESET; irq < s->num_irq; irq++) {
+    for (irq = ARMV7M_EXCP_RESET; irq < s->num_irq;
+         irq = nvic_next_live_irq(s, irq + 1)) {
         if (s->vectors[irq].active ||
             (check_sec && irq < NVIC_INTERNAL_VECTORS &&
              s->sec_vectors[irq].active)) {
@@ -127,23 +181,17 @@ static bool nvic_rettobase(NVICState *s)
  */
 static bool nvic_isrpending(NVICState *s)
 {
-    int irq;
-
     /*
      * We can shortcut if the highest priority pending interrupt
-     * happens to be external; if not we need to check the whole
-     * vectors[] array.
+     * happens to be external; if not we need to check the
+     * pending_irqs bitmap.
      */
     if (s->vectpending > NVIC_FIRST_IRQ) {
         return true;
     }
 
-    for (irq = NVIC_FIRST_IRQ; irq < s->num_irq; irq++) {
-        if (s->vectors[irq].pending) {
-            return true;
-        }
-    }
-    return false;
+    return find_next_bit(s->pending_irqs, s->num_irq,
+                         NVIC_FIRST_IRQ) < s->num_irq;
 }
 
 static bool exc_is_banked(int exc)
@@ -242,7 +290,7 @@ static void nvic_recompute_state_secure(NVICState *s)
      * Annoyingly, now we have two prigroup values (for S and NS)
      * we can't do the loop comparison on raw priority values.
      */
-    for (i = 1; i < s->num_irq; i++) {
+    for (i = 1; i < s->num_irq; i = nvic_next_live_irq(s, i + 1)) {
         for (bank = M_REG_S; bank >= M_REG_NS; bank--) {
             VecInfo *vec;
             int prio, subprio;
@@ -306,7 +354,7 @@ static void nvic_recompute_state(NVICState *s)
         return;
     }
 
-    for (i = 1; i < s->num_irq; i++) {
+    for (i = 1; i < s->num_irq; i = nvic_next_live_irq(s, i + 1)) {
         VecInfo *vec = &s->vectors[i];
 
         if (vec->enabled && vec->pending && vec->prio < pend_prio) {
@@ -517,6 +565,7 @@ static void armv7m_nvic_clear_pending(NVICState *s, int irq, bool secure)
     trace_nvic_clear_pending(irq, secure, vec->enabled, vec->prio);
     if (vec->pending) {
         vec->pending = 0;
+        nvic_irq_state_changed(s, irq);
         nvic_irq_update(s);
     }
 }
@@ -657,6 +706,10 @@ static void do_armv7m_nvic_set_pending(void *opaque, int irq, bool secure,
 
     if (!vec->pending) {
         vec->pending = 1;
+        nvic_irq_state_changed(s, irq);
+        if (s->cpu->env.v7m.scr[targets_secure] & R_V7M_SCR_SEVONPEND_MASK) {
+            arm_v7m_send_event(s->cpu);
+        }
         nvic_irq_update(s);
     }
 }
@@ -791,6 +844,7 @@ void armv7m_nvic_acknowledge_irq(NVICState *s)
 
     vec->active = 1;
     vec->pending = 0;
+    nvic_irq_state_changed(s, pending);
 
     write_v7m_exception(env, s->vectpending);
 
@@ -900,6 +954,7 @@ int armv7m_nvic_complete_irq(NVICState *s, int irq, bool secure)
         assert(irq >= NVIC_FIRST_IRQ);
         vec->pending = 1;
     }
+    nvic_irq_state_changed(s, irq);
 
     nvic_irq_update(s);
 
@@ -1656,8 +1711,8 @@ static void nvic_writel(NVICState *s, uint32_t offset, uint32_t value,
         }
         /* We don't implement deep-sleep so these bits are RAZ/WI.
          * The other bits in the register are banked.
-         * QEMU's implementation ignores SEVONPEND and SLEEPONEXIT, which
-         * is architecturally permitted.
+         * QEMU's implementation ignores SLEEPONEXIT, which is
+         * architecturally permitted.
          */
         value &= ~(R_V7M_SCR_SLEEPDEEP_MASK | R_V7M_SCR_SLEEPDEEPS_MASK);
         cpu->env.v7m.scr[attrs.secure] = value;
@@ -1872,6 +1927,7 @@ static void nvic_writel(NVICState *s, uint32_t offset, uint32_t value,
                 return;
             }
             cpu->env.pmsav8.rbar[attrs.secure][region] = value;
+            cpu->env.pmsav8.seg_valid[attrs.secure] = false;
             tlb_flush(CPU(cpu));
             return;
         }
@@ -1897,6 +1953,7 @@ static void nvic_writel(NVICState *s, uint32_t offset, uint32_t value,
         }
 
         cpu->env.pmsav7.drbar[region] = value & ~0x1f;
+        cpu->env.pmsav7.seg_valid = false;
         tlb_flush(CPU(cpu));
         break;
     }
@@ -1922,6 +1979,7 @@ static void nvic_writel(NVICState *s, uint32_t offset, uint32_t value,
                 return;
             }
             cpu->env.pmsav8.rlar[attrs.secure][region] = value;
+            cpu->env.pmsav8.seg_valid[attrs.secure] = false;
             tlb_flush(CPU(cpu));
             return;
         }
@@ -1932,6 +1990,7 @@ static void nvic_writel(NVICState *s, uint32_t offset, uint32_t value,
 
         cpu->env.pmsav7.drsr[region] = value & 0xff3f;
         cpu->env.pmsav7.dracr[region] = (value >> 16) & 0x173f;
+        cpu->env.pmsav7.seg_valid = false;
         tlb_flush(CPU(cpu));
         break;
     }
@@ -2364,6 +2423,7 @@ static MemTxResult nvic_sysreg_write(void *opaque, hwaddr addr,
             if (value & (1 << i) &&
                 (attrs.secure || s->itns[startvec + i])) {
                 s->vectors[startvec + i].enabled = setval;
+                nvic_irq_state_changed(s, startvec + i);
             }
         }
         nvic_irq_update(s);
@@ -2389,6 +2449,7 @@ static MemTxResult nvic_sysreg_write(void *opaque, hwaddr addr,
                 !(setval == 0 && s->vectors[startvec + i].level &&
                   !s->vectors[startvec + i].active)) {
                 s->vectors[startvec + i].pending = setval;
+                nvic_irq_state_changed(s, startvec + i);
             }
         }
         nvic_irq_update(s);
@@ -2489,6 +2550,7 @@ static int nvic_post_load(void *opaque, int version_id)
         }
     }
 
+    nvic_rebuild_irq_state(s);
     nvic_recompute_state(s);
 
     return 0;
@@ -2586,6 +2648,8 @@ static void armv7m_nvic_reset(DeviceState *dev)
 
     memset(s->vectors, 0, sizeof(s->vectors));
     memset(s->sec_vectors, 0, sizeof(s->sec_vectors));
+    bitmap_zero(s->pending_irqs, NVIC_MAX_VECTORS);
+    bitmap_zero(s->live_irqs, NVIC_MAX_VECTORS);
     s->prigroup[M_REG_NS] = 0;
     s->prigroup[M_REG_S] = 0;
 
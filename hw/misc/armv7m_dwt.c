@@ -0,0 +1,229 @@
+/*
+ * Arm M-profile DWT (Data Watchpoint and Trace) unit
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 or
+ *  (at your option) any later version.
+ */
+
+#include "qemu/osdep.h"
+#include "hw/misc/armv7m_dwt.h"
+#include "hw/qdev-clock.h"
+#include "migration/vmstate.h"
+#include "exec/icount.h"
+#include "qemu/log.h"
+#include "qemu/module.h"
+#include "qemu/timer.h"
+#include "trace.h"
+
+#define DWT_CTRL_CYCCNTENA (1 << 0)
+#define DWT_CTRL_NOPRFCNT (1 << 24)
+#define DWT_CTRL_NOEXTTRIG (1 << 26)
+#define DWT_CTRL_NOTRCPKT (1 << 27)
+/* NUMCOMP, bits [31:28], is zero: we implement no comparators */
+#define DWT_CTRL_RO_BITS \
+    (DWT_CTRL_NOPRFCNT | DWT_CTRL_NOEXTTRIG | DWT_CTRL_NOTRCPKT)
+
+static const uint8_t dwt_id[] = {
+    0x04, 0x00, 0x00, 0x00, /* PID4..PID7 */
+    0x02, 0xb0, 0x3b, 0x00, /* PID0..PID3 */
+    0x0d, 0xe0, 0x05, 0xb1, /* CID0..CID3 */
+};
+
+/* The current time in the units CYCCNT counts in */
+static int64_t dwt_now(ARMv7MDWT *s)
+{
+    int64_t ns;
+
+    if (icount_enabled()) {
+        return icount_get_raw();
+    }
+    ns = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL);
+    if (clock_is_enabled(s->cpuclk)) {
+        return clock_ns_to_ticks(s->cpuclk, ns);
+    }
+    return ns;
+}
+
+static uint32_t dwt_cyccnt(ARMv7MDWT *s)
+{
+    if (!(s->ctrl & DWT_CTRL_CYCCNTENA)) {
+        return s->cyccnt;
+    }
+    return s->cyccnt + (uint32_t)(dwt_now(s) - s->start);
+}
+
+/* Fold the count so far into s->cyccnt and restart from now */
+static void dwt_sync(ARMv7MDWT *s)
+{
+    s->cyccnt = dwt_cyccnt(s);
+    s->start = dwt_now(s);
+}
+
+static MemTxResult dwt_read(void *opaque, hwaddr addr,
+                            uint64_t *data, unsigned size,
+                            MemTxAttrs attrs)
+{
+    ARMv7MDWT *s = ARMV7M_DWT(opaque);
+
+    if (attrs.user) {
+        return MEMTX_ERROR;
+    }
+
+    switch (addr) {
+    case 0x0: /* DWT_CTRL */
+        *data = s->ctrl | DWT_CTRL_RO_BITS;
+        break;
+    case 0x4: /* DWT_CYCCNT */
+        *data = dwt_cyccnt(s);
+        break;
+    case 0x8 ... 0x18: /* CPICNT, EXCCNT, SLEEPCNT, LSUCNT, FOLDCNT */
+        /* Not implemented, as advertised by DWT_CTRL.NOPRFCNT */
+        *data = 0;
+        break;
+    case 0xfb4: /* DWT_LSR */
+        *data = 0;
+        break;
+    case 0xfd0 ... 0xffc: /* ID registers */
+        *data = dwt_id[(addr - 0xfd0) >> 2];
+        break;
+    default:
+        qemu_log_mask(LOG_UNIMP, "Read DWT register offset 0x%x\n",
+                      (uint32_t)addr);
+        *data = 0;
+        break;
+    }
+    trace_armv7m_dwt_read(addr, *data, size);
+    return MEMTX_OK;
+}
+
+static MemTxResult dwt_write(void *opaque, hwaddr addr,
+                             uint64_t value, unsigned size,
+                             MemTxAttrs attrs)
+{
+    ARMv7MDWT *s = ARMV7M_DWT(opaque);
+
+    if (attrs.user) {
+        return MEMTX_ERROR;
+    }
+
+    trace_armv7m_dwt_write(addr, value, size);
+
+    switch (addr) {
+    case 0x0: /* DWT_CTRL */
+        dwt_sync(s);
+        s->ctrl = value & DWT_CTRL_CYCCNTENA;
+        break;
+    case 0x4: /* DWT_CYCCNT */
+        s->cyccnt = value;
+        s->start = dwt_now(s);
+        break;
+    case 0x8 ... 0x18: /* CPICNT, EXCCNT, SLEEPCNT, LSUCNT, FOLDCNT */
+    case 0xfb0: /* DWT_LAR */
+        break;
+    default:
+        qemu_log_mask(LOG_UNIMP, "Write to DWT register offset 0x%x\n",
+                      (uint32_t)addr);
+        break;
+    }
+    return MEMTX_OK;
+}
+
+static const MemoryRegionOps dwt_ops = {
+    .read_with_attrs = dwt_read,
+    .write_with_attrs = dwt_write,
+    .endianness = DEVICE_NATIVE_ENDIAN,
+    .valid.min_access_size = 4,
+    .valid.max_access_size = 4,
+};
+
+static void dwt_clk_update(void *opaque, ClockEvent event)
+{
+    ARMv7MDWT *s = ARMV7M_DWT(opaque);
+
+    /*
+     * Count the cycles before a clock frequency change at the old
+     * frequency, and restart from the new one after it.
+     */
+    if (event == ClockPreUpdate) {
+        s->cyccnt = dwt_cyccnt(s);
+    } else {
+        s->start = dwt_now(s);
+    }
+}
+
+static void armv7m_dwt_init(Object *obj)
+{
+    SysBusDevice *sbd = SYS_BUS_DEVICE(obj);
+    ARMv7MDWT *s = ARMV7M_DWT(obj);
+
+    memory_region_init_io(&s->iomem, obj, &dwt_ops,
+                          s, "armv7m-dwt", 0x1000);
+    sysbus_init_mmio(sbd, &s->iomem);
+    s->cpuclk = qdev_init_clock_in(DEVICE(obj), "cpuclk", dwt_clk_update, s,
+                                   ClockPreUpdate | ClockUpdate);
+}
+
+static void armv7m_dwt_reset_hold(Object *obj, ResetType type)
+{
+    ARMv7MDWT *s = ARMV7M_DWT(obj);
+
+    s->ctrl = 0;
+    s->cyccnt = 0;
+    s->start = 0;
+}
+
+static int armv7m_dwt_pre_save(void *opaque)
+{
+    ARMv7MDWT *s = ARMV7M_DWT(opaque);
+
+    /* @start is relative to this QEMU's clocks; send the folded count */
+    dwt_sync(s);
+    return 0;
+}
+
+static int armv7m_dwt_post_load(void *opaque, int version_id)
+{
+    ARMv7MDWT *s = ARMV7M_DWT(opaque);
+
+    s->start = dwt_now(s);
+    return 0;
+}
+
+static const VMStateDescription vmstate_armv7m_dwt = {
+    .name = "armv7m-dwt",
+    .version_id = 1,
+    .minimum_version_id = 1,
+    .pre_save = armv7m_dwt_pre_save,
+    .post_load = armv7m_dwt_post_load,
+    .fields = (const VMStateField[]) {
+        VMSTATE_CLOCK(cpuclk, ARMv7MDWT),
+        VMSTATE_UINT32(ctrl, ARMv7MDWT),
+        VMSTATE_UINT32(cyccnt, ARMv7MDWT),
+        VMSTATE_END_OF_LIST()
+    }
+};
+
+static void armv7m_dwt_class_init(ObjectClass *klass, const void *data)
+{
+    DeviceClass *dc = DEVICE_CLASS(klass);
+    ResettableClass *rc = RESETTABLE_CLASS(klass);
+
+    dc->vmsd = &vmstate_armv7m_dwt;
+    rc->phases.hold = armv7m_dwt_reset_hold;
+}
+
+static const TypeInfo armv7m_dwt_info = {
+    .name = TYPE_ARMV7M_DWT,
+    .parent = TYPE_SYS_BUS_DEVICE,
+    .instance_size = sizeof(ARMv7MDWT),
+    .instance_init = armv7m_dwt_init,
+    .class_init = armv7m_dwt_class_init,
+};
+
+static void armv7m_dwt_register_types(void)
+{
+    type_register_static(&armv7m_dwt_info);
+}
+
+type_init(armv7m_dwt_register_types);
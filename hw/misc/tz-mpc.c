@@ -76,35 +76,30 @@ static void tz_mpc_irq_update(TZMPC *s)
     qemu_set_irq(s->irq, s->int_stat && s->int_en);
 }
 
-static void tz_mpc_iommu_notify(TZMPC *s, uint32_t lutidx,
-                                uint32_t oldlut, uint32_t newlut)
+static void tz_mpc_iommu_notify_range(TZMPC *s, hwaddr addr, hwaddr len,
+                                      bool block_is_ns)
 {
-    /* Called when the LUT word at lutidx has changed from oldlut to newlut;
-     * must call the IOMMU notifiers for the changed blocks.
+    /* Notify the change of every block in [addr, addr + len) to
+     * block_is_ns, using as few naturally aligned power-of-2 sized
+     * IOMMU TLB entries as possible.
      */
-    IOMMUTLBEvent event = {
-        .entry = {
-            .addr_mask = s->blocksize - 1,
-        }
-    };
-    hwaddr addr = lutidx * s->blocksize * 32;
-    int i;
+    IOMMUTLBEvent event = {};
 
-    for (i = 0; i < 32; i++, addr += s->blocksize) {
-        bool block_is_ns;
+    while (len) {
+        hwaddr size = pow2floor(len);
 
-        if (!((oldlut ^ newlut) & (1 << i))) {
-            continue;
+        if (addr) {
+            size = MIN(size, (hwaddr)1 << ctz64(addr));
         }
-        /* This changes the mappings for both the S and the NS space,
-         * so we need to do four notifies: an UNMAP then a MAP for each.
-         */
-        block_is_ns = newlut & (1 << i);
 
-        trace_tz_mpc_iommu_notify(addr);
+        trace_tz_mpc_iommu_notify(addr, size);
         event.entry.iova = addr;
         event.entry.translated_addr = addr;
+        event.entry.addr_mask = size - 1;
 
+        /* This changes the mappings for both the S and the NS space,
+         * so we need to do four notifies: an UNMAP then a MAP for each.
+         */
         event.type = IOMMU_NOTIFIER_UNMAP;
         event.entry.perm = IOMMU_NONE;
         memory_region_notify_iommu(&s->upstream, IOMMU_IDX_S, event);
@@ -124,6 +119,32 @@ static void tz_mpc_iommu_notify(TZMPC *s, uint32_t lutidx,
             event.entry.target_as = &s->blocked_io_as;
         }
         memory_region_notify_iommu(&s->upstream, IOMMU_IDX_NS, event);
+
+        addr += size;
+        len -= size;
+    }
+}
+
+static void tz_mpc_iommu_notify(TZMPC *s, uint32_t lutidx,
+                                uint32_t oldlut, uint32_t newlut)
+{
+    /* Called when the LUT word at lutidx has changed from oldlut to newlut;
+     * must call the IOMMU notifiers for the changed blocks. Runs of
+     * adjacent blocks that changed to the same setting are notified
+     * together rather than one block at a time.
+     */
+    hwaddr base = lutidx * s->blocksize * 32;
+    uint32_t changed = oldlut ^ newlut;
+
+    while (changed) {
+        int first = ctz32(changed);
+        bool block_is_ns = newlut & (1U << first);
+        uint32_t same = changed & (block_is_ns ? newlut : ~newlut);
+        int count = cto32(same >> first);
+
+        tz_mpc_iommu_notify_range(s, base + first * s->blocksize,
+                                  count * s->blocksize, block_is_ns);
+        changed &= ~MAKE_64BIT_MASK(first, count);
     }
 }
 
@@ -360,6 +381,46 @@ static inline bool tz_mpc_cfg_ns(TZMPC *s, hwaddr addr)
     return s->blk_lut[blkword] & blkbit;
 }
 
+static unsigned tz_mpc_block_group_bits(TZMPC *s, hwaddr blknum)
+{
+    /* Return log2 of the number of blocks in the largest naturally
+     * aligned group around blknum whose blocks all have the same cfg_ns
+     * setting, so that a single IOMMU TLB entry can cover all of them.
+     */
+    hwaddr nblocks = memory_region_size(MEMORY_REGION(&s->upstream)) /
+        s->blocksize;
+    uint32_t word = s->blk_lut[blknum / 32];
+    uint32_t want = (word & (1U << (blknum % 32))) ? ~0U : 0;
+    unsigned bits;
+
+    /* Groups within one LUT word */
+    for (bits = 0; bits < 5; bits++) {
+        hwaddr count = 2ULL << bits;
+        hwaddr first = blknum & ~(count - 1);
+        uint32_t mask = MAKE_64BIT_MASK(first % 32, count);
+
+        if (first + count > nblocks || (word & mask) != (want & mask)) {
+            return bits;
+        }
+    }
+
+    /* Groups of whole LUT words */
+    for (;; bits++) {
+        hwaddr count = 2ULL << bits;
+        hwaddr first = blknum & ~(count - 1);
+        hwaddr w;
+
+        if (first + count > nblocks) {
+            return bits;
+        }
+        for (w = first / 32; w < (first + count) / 32; w++) {
+            if (s->blk_lut[w] != want) {
+                return bits;
+            }
+        }
+    }
+}
+
 static MemTxResult tz_mpc_handle_block(TZMPC *s, hwaddr addr, MemTxAttrs attrs)
 {
     /* Handle a blocked transaction: raise IRQ, capture info, etc */
@@ -427,12 +488,14 @@ static IOMMUTLBEntry tz_mpc_translate(IOMMUMemoryRegion *iommu,
                                       int iommu_idx)
 {
     TZMPC *s = TZ_MPC(container_of(iommu, TZMPC, upstream));
+    unsigned bits = tz_mpc_block_group_bits(s, addr / s->blocksize);
+    hwaddr mask = (s->blocksize << bits) - 1;
     bool ok;
 
     IOMMUTLBEntry ret = {
-        .iova = addr & ~(s->blocksize - 1),
-        .translated_addr = addr & ~(s->blocksize - 1),
-        .addr_mask = s->blocksize - 1,
+        .iova = addr & ~mask,
+        .translated_addr = addr & ~mask,
+        .addr_mask = mask,
         .perm = IOMMU_RW,
     };
 
@@ -441,6 +504,8 @@ static IOMMUTLBEntry tz_mpc_translate(IOMMUMemoryRegion *iommu,
      * downstream_as or blocked_io_as, as appropriate.
      * If the LUT cfg_ns bit is 1, only non-secure transactions
      * may pass. If the bit is 0, only secure transactions may pass.
+     * The entry covers every neighbouring block with the same setting,
+     * so that large accesses need not be split at each block.
      */
     ok = tz_mpc_cfg_ns(s, addr) == (iommu_idx == IOMMU_IDX_NS);
 
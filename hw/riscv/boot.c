@@ -165,7 +165,7 @@ target_ulong riscv_load_firmware(const char *firmware_filename,
 
     if (load_elf_ram_sym(firmware_filename, NULL, NULL, NULL,
                          &firmware_entry, NULL, &firmware_end, NULL,
-                         0, EM_RISCV, 1, 0, NULL, true, sym_cb) > 0) {
+                         0, EM_RISCV, 1, 0, NULL, true, sym_cb, NULL) > 0) {
         *firmware_load_addr = firmware_entry;
         return firmware_end;
     }
@@ -247,7 +247,7 @@ void riscv_load_kernel(MachineState *machine,
     kernel_size = load_elf_ram_sym(kernel_filename, NULL, NULL, NULL, NULL,
                                    &info->image_low_addr, &info->image_high_addr,
                                    NULL, ELFDATA2LSB, EM_RISCV,
-                                   1, 0, NULL, true, sym_cb);
+                                   1, 0, NULL, true, sym_cb, NULL);
     if (kernel_size > 0) {
         info->kernel_size = kernel_size;
         goto out;
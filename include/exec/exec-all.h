@@ -138,6 +138,25 @@ void tb_set_jmp_target(TranslationBlock *tb, int n, uintptr_t addr);
  */
 struct MemoryRegionSection *iotlb_to_section(CPUState *cpu,
                                              hwaddr index, MemTxAttrs attrs);
+
+/**
+ * iotlb_resolve_subpage:
+ * @cpu: CPU performing the access
+ * @section: a section returned by iotlb_to_section() for a subpage
+ * @attrs: memory transaction attributes
+ * @offset: offset of the access in @section; updated on success
+ * @size: size of the access in bytes
+ *
+ * A page that is shared by several MemoryRegions is mapped in the
+ * IOTLB as a single subpage section, whose accessors dispatch again
+ * through the flatview.  For an access that lies entirely within one
+ * MMIO region, return that region's section instead, and set @offset
+ * to the offset within it, so that the caller can dispatch to it
+ * directly.  Otherwise return @section unchanged.
+ */
+struct MemoryRegionSection *
+iotlb_resolve_subpage(CPUState *cpu, struct MemoryRegionSection *section,
+                      MemTxAttrs attrs, hwaddr *offset, unsigned size);
 #endif
 
 #if !defined(CONFIG_USER_ONLY)
@@ -51,6 +51,8 @@ typedef struct RAMList {
     QLIST_HEAD(, RAMBlock) blocks;
     DirtyMemoryBlocks *dirty_memory[DIRTY_MEMORY_NUM];
     unsigned int num_dirty_blocks;
+    /* Number of RAMBlocks with sub-page dirty tracking */
+    unsigned int num_subpage_dirty;
     uint32_t version;
     QLIST_HEAD(, RAMBlockNotifier) ramblock_notifiers;
 } RAMList;
@@ -118,6 +118,16 @@ bool device_is_dynamic_sysbus(MachineClass *mc, DeviceState *dev);
 MemoryRegion *machine_consume_memdev(MachineState *machine,
                                      HostMemoryBackend *backend);
 
+/*
+ * Returns the RAM for a fixed-size board memory called @name: the
+ * region of @backend, which must be exactly @size bytes, if one was
+ * given, or @mr initialized as plain RAM otherwise.
+ */
+MemoryRegion *machine_init_board_ram(MachineState *machine,
+                                     HostMemoryBackend *backend,
+                                     MemoryRegion *mr, const char *name,
+                                     uint64_t size);
+
 /**
  * CPUArchId:
  * @arch_id - architecture-dependent CPU ID of present or possible CPU
@@ -206,6 +206,9 @@ struct CPUClass {
 /* Use a fully associative victim tlb of 8 entries. */
 #define CPU_VTLB_SIZE 8
 
+/* Use a fully associative table of 8 entries for sub-page translations. */
+#define CPU_SUBPAGE_TLB_SIZE 8
+
 /*
  * The full TLB entry, which is not accessed by generated TCG code,
  * so the layout is not as critical as that of CPUTLBEntry. This is
@@ -292,6 +295,17 @@ typedef struct CPUTLBDesc {
     /* The tlb victim table, in two parts.  */
     CPUTLBEntry vtable[CPU_VTLB_SIZE];
     CPUTLBEntryFull vfulltlb[CPU_VTLB_SIZE];
+    /*
+     * Translations smaller than TARGET_PAGE_SIZE (e.g. from an MPU with
+     * fine grained regions) are never hit in the tlb proper.  Keep the
+     * most recent ones here, each valid for the naturally aligned block
+     * of 1 << lg_page_size bytes at subpage_base, so that they can be
+     * reused without calling tlb_fill_align again.
+     */
+    size_t subpage_index;
+    vaddr subpage_base[CPU_SUBPAGE_TLB_SIZE];
+    CPUTLBEntry subpage_table[CPU_SUBPAGE_TLB_SIZE];
+    CPUTLBEntryFull subpage_fulltlb[CPU_SUBPAGE_TLB_SIZE];
     CPUTLBEntryFull *fulltlb;
 } CPUTLBDesc;
 
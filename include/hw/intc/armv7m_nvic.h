@@ -14,6 +14,7 @@
 #include "hw/sysbus.h"
 #include "hw/timer/armv7m_systick.h"
 #include "qom/object.h"
+#include "qemu/bitmap.h"
 
 #define TYPE_NVIC "armv7m_nvic"
 OBJECT_DECLARE_SIMPLE_TYPE(NVICState, NVIC)
@@ -75,6 +76,14 @@ struct NVICState {
     bool vectpending_is_s_banked;
     int exception_prio; /* group prio of the highest prio active exception */
     int vectpending_prio; /* group prio of the exception in vectpending */
+    /* Also cached (rebuilt from vectors[] on reset and migration), for
+     * external interrupts only, so that recomputing the above only has to
+     * visit the interrupts which can affect it:
+     *  - pending_irqs: bit set if the interrupt is pending
+     *  - live_irqs: bit set if it is enabled and pending, or active
+     */
+    DECLARE_BITMAP(pending_irqs, NVIC_MAX_VECTORS);
+    DECLARE_BITMAP(live_irqs, NVIC_MAX_VECTORS);
 
     MemoryRegion sysregmem;
 
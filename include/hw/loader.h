@@ -131,6 +131,7 @@ const char *load_elf_strerror(ssize_t error);
  *      is used if nothing is supplied here.
  * @load_rom : Load ELF binary as ROM
  * @sym_cb: Callback function for symbol table entries
+ * @sym_opaque: Opaque pointer passed to @sym_cb
  *
  * Load an ELF file's contents to the emulated system's address space.
  * Clients may optionally specify a callback to perform address
@@ -144,7 +145,8 @@ const char *load_elf_strerror(ssize_t error);
  * ELF header and no checks will be carried out against the machine type.
  */
 typedef void (*symbol_fn_t)(const char *st_name, int st_info,
-                            uint64_t st_value, uint64_t st_size);
+                            uint64_t st_value, uint64_t st_size,
+                            void *opaque);
 
 ssize_t load_elf_ram_sym(const char *filename,
                          uint64_t (*elf_note_fn)(void *, void *, bool),
@@ -153,7 +155,8 @@ ssize_t load_elf_ram_sym(const char *filename,
                          uint64_t *lowaddr, uint64_t *highaddr,
                          uint32_t *pflags, int elf_data_order, int elf_machine,
                          int clear_lsb, int data_swab,
-                         AddressSpace *as, bool load_rom, symbol_fn_t sym_cb);
+                         AddressSpace *as, bool load_rom, symbol_fn_t sym_cb,
+                         void *sym_opaque);
 
 /** load_elf_as:
  * Same as load_elf_ram_sym(), but always loads the elf as ROM
@@ -0,0 +1,48 @@
+/*
+ * Arm M-profile DWT (Data Watchpoint and Trace) unit
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 or
+ *  (at your option) any later version.
+ */
+
+/*
+ * This is a model of the DWT register block of an M-profile CPU
+ * (the registers starting at 0xE0001000 with DWT_CTRL).
+ *
+ * Only the cycle counter is implemented: there are no comparators and
+ * no profiling counters, which DWT_CTRL reports. CYCCNT counts guest
+ * instructions when icount is enabled, and otherwise ticks of the CPU
+ * clock derived from QEMU_CLOCK_VIRTUAL, so that the guest can time its
+ * own code. DEMCR.TRCENA is not required to be set for it to count.
+ *
+ * QEMU interface:
+ *  + sysbus MMIO region 0: the register bank
+ *  + Clock input "cpuclk": the CPU clock CYCCNT counts in when icount
+ *    is not enabled (if it is not connected, CYCCNT counts nanoseconds)
+ */
+
+#ifndef HW_MISC_ARMV7M_DWT_H
+#define HW_MISC_ARMV7M_DWT_H
+
+#include "hw/sysbus.h"
+#include "qom/object.h"
+
+#define TYPE_ARMV7M_DWT "armv7m-dwt"
+OBJECT_DECLARE_SIMPLE_TYPE(ARMv7MDWT, ARMV7M_DWT)
+
+struct ARMv7MDWT {
+    /*< private >*/
+    SysBusDevice parent_obj;
+
+    /*< public >*/
+    MemoryRegion iomem;
+    Clock *cpuclk;
+
+    uint32_t ctrl;
+    /* CYCCNT value at @start, which is in dwt_now() units */
+    uint32_t cyccnt;
+    int64_t start;
+};
+
+#endif
@@ -38,6 +38,15 @@ int64_t cpu_get_clock(void);
 
 void qemu_timer_notify_cb(void *opaque, QEMUClockType type);
 
+/*
+ * Idle warp: without icount, let QEMU_CLOCK_VIRTUAL jump to the next
+ * deadline while all vCPUs are idle. cpu_idle_warp() is called by the
+ * main loop and does nothing unless enabled and every vCPU is idle.
+ */
+void cpu_set_idle_warp(bool enable);
+bool cpu_idle_warp_enabled(void);
+void cpu_idle_warp(void);
+
 /* get/set VIRTUAL clock and VM elapsed ticks via the cpus accel interface */
 int64_t cpus_get_virtual_clock(void);
 void cpus_set_virtual_clock(int64_t new_time);
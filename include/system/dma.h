@@ -32,8 +32,6 @@ typedef uint64_t dma_addr_t;
 #define DMA_ADDR_BITS 64
 #define DMA_ADDR_FMT "%" PRIx64
 
-typedef struct ScatterGatherEntry ScatterGatherEntry;
-
 struct QEMUSGList {
     ScatterGatherEntry *sg;
     int nsg;
@@ -2047,6 +2047,56 @@ void memory_region_writeback(MemoryRegion *mr, hwaddr addr, hwaddr size);
  */
 void memory_region_set_log(MemoryRegion *mr, bool log, unsigned client);
 
+/**
+ * memory_region_set_dirty_granularity: Track %DIRTY_MEMORY_VGA for TCG
+ *                                      stores at a sub-page granularity.
+ *
+ * By default a store marks its whole target page dirty, so a display
+ * device redraws every scanline sharing the page with a changed pixel.
+ * With a finer @granularity, stores from TCG go through the slow path
+ * and only mark the touched blocks of @granularity bytes; a page that
+ * takes many stores between two snapshots is marked dirty as a whole
+ * again, so that bulk updates keep running on the fast path.
+ *
+ * The finer dirty information is only visible through
+ * memory_region_snapshot_and_clear_dirty() and
+ * memory_region_test_and_clear_dirty(); writes from anything other than
+ * TCG (DMA, KVM, ...) still dirty whole pages.
+ *
+ * @granularity is rounded up to a power of two and to the smallest size
+ * supported (a page split into one bitmap word); if that is not smaller
+ * than a target page, tracking stays page-granular.  Only RAM regions are
+ * supported, and the granularity can only be set once, typically when the
+ * device is realized.
+ *
+ * @mr: the memory region being updated.
+ * @granularity: the size in bytes covered by each sub-page dirty bit.
+ */
+void memory_region_set_dirty_granularity(MemoryRegion *mr,
+                                         uint64_t granularity);
+
+/**
+ * memory_region_set_dirty_hold: Keep %DIRTY_MEMORY_VGA pages dirty for
+ *                               several snapshots.
+ *
+ * Normally memory_region_snapshot_and_clear_dirty() clears the dirty bits
+ * and resets the TLBs of every vCPU, so that the first store to each page
+ * after every display refresh takes the TCG slow path again.  With a hold
+ * of @snapshots, a page found dirty keeps its dirty bit, and stays on the
+ * TLB fast path, until it has been reported dirty by @snapshots
+ * consecutive snapshots; only then is it cleared and trapped again.
+ *
+ * This trades redrawing pages that are no longer being written for up to
+ * @snapshots refreshes against one slow-path store per page every
+ * @snapshots refreshes, instead of every refresh, for pages the guest
+ * redraws continuously.  Values below 2 leave the default behaviour.  The
+ * hold can only be set once, typically when the device is realized.
+ *
+ * @mr: the memory region being updated.
+ * @snapshots: the number of snapshots a dirty page is reported in.
+ */
+void memory_region_set_dirty_hold(MemoryRegion *mr, unsigned snapshots);
+
 /**
  * memory_region_set_dirty: Mark a range of bytes as dirty in a memory region.
  *
@@ -2108,6 +2158,29 @@ DirtyBitmapSnapshot *memory_region_snapshot_and_clear_dirty(MemoryRegion *mr,
                                                             hwaddr size,
                                                             unsigned client);
 
+/**
+ * memory_region_snapshot_and_clear_dirty_reuse: Like
+ *     memory_region_snapshot_and_clear_dirty(), but fill in an existing
+ *     snapshot.
+ *
+ * @snap is only reallocated when it is too small for the requested range,
+ * so a caller that keeps the returned snapshot around for its next update
+ * does not allocate memory in the steady state.  @snap may be NULL.
+ * Returns the snapshot to use from now on; @snap must not be used after
+ * the call.  Use g_free to release it.
+ *
+ * @mr: the memory region being queried.
+ * @addr: the address (relative to the start of the region) being queried.
+ * @size: the size of the range being queried.
+ * @client: the user of the logging information; typically %DIRTY_MEMORY_VGA.
+ * @snap: a snapshot returned by an earlier call, or NULL.
+ */
+DirtyBitmapSnapshot *
+memory_region_snapshot_and_clear_dirty_reuse(MemoryRegion *mr,
+                                             hwaddr addr, hwaddr size,
+                                             unsigned client,
+                                             DirtyBitmapSnapshot *snap);
+
 /**
  * memory_region_snapshot_get_dirty: Check whether a range of bytes is dirty
  *                                   in the specified dirty bitmap snapshot.
@@ -2121,6 +2194,32 @@ bool memory_region_snapshot_get_dirty(MemoryRegion *mr,
                                       DirtyBitmapSnapshot *snap,
                                       hwaddr addr, hwaddr size);
 
+/**
+ * memory_region_snapshot_next_dirty: Find the next run of dirty pages
+ *                                    in a dirty bitmap snapshot.
+ *
+ * Searches [@addr, @end) for the first dirty page and the end of the run
+ * of dirty pages that starts there (or blocks, for a region with a finer
+ * granularity set by memory_region_set_dirty_granularity()).  The bitmap
+ * is scanned a word (i.e. 64 pages on 64bit hosts) at a time, so this is
+ * much cheaper than calling memory_region_snapshot_get_dirty() for every
+ * scanline.
+ *
+ * Returns true and sets @span_start and @span_end, clipped to
+ * [@addr, @end), if a dirty page was found; false otherwise.
+ *
+ * @mr: the memory region being queried.
+ * @snap: the dirty bitmap snapshot
+ * @addr: the start of the search, relative to the start of the region.
+ * @end: the end of the search, relative to the start of the region.
+ * @span_start: set to the start of the dirty run.
+ * @span_end: set to the end of the dirty run.
+ */
+bool memory_region_snapshot_next_dirty(MemoryRegion *mr,
+                                       DirtyBitmapSnapshot *snap,
+                                       hwaddr addr, hwaddr end,
+                                       hwaddr *span_start, hwaddr *span_end);
+
 /**
  * memory_region_reset_dirty: Mark a range of pages as clean, for a specified
  *                            client.
@@ -2154,6 +2253,21 @@ void memory_region_reset_dirty(MemoryRegion *mr, hwaddr addr,
  */
 void memory_region_flush_rom_device(MemoryRegion *mr, hwaddr addr, hwaddr size);
 
+/**
+ * memory_region_flush_ram: Mark a range of RAM dirty and invalidate TBs
+ *                          after writing it through a host pointer.
+ *
+ * Devices that store directly into the pointer returned by
+ * qemu_map_ram_ptr() for a translated RAM region must use this function
+ * so that migration, display and TCG see the modification.
+ *
+ * @mr: the RAM region that was written.
+ * @addr: the start, relative to the start of the region, of the range
+ *        written.
+ * @size: the size, in bytes, of the range written.
+ */
+void memory_region_flush_ram(MemoryRegion *mr, hwaddr addr, hwaddr size);
+
 /**
  * memory_region_set_readonly: Turn a memory region read-only (or read-write)
  *
@@ -2662,6 +2776,32 @@ MemTxResult address_space_rw(AddressSpace *as, hwaddr addr,
                              MemTxAttrs attrs, void *buf,
                              hwaddr len, bool is_write);
 
+/**
+ * address_space_rw_sg: scatter/gather transfer to or from an address space.
+ *
+ * Transfer up to @len bytes between the contiguous buffer @buf and the
+ * list of address space ranges @sg, in order, as a device doing DMA
+ * through a descriptor list would. This is equivalent to calling
+ * address_space_rw() for each entry, but the whole transfer is done
+ * against a single #FlatView within one RCU critical section, so it is
+ * cheaper for devices which move many kilobytes at a time.
+ *
+ * Return a MemTxResult indicating whether the operation succeeded
+ * or failed; the results of the individual entries are ORed together.
+ *
+ * @as: #AddressSpace to be accessed
+ * @sg: array of address ranges
+ * @nsg: the number of entries in @sg
+ * @attrs: memory transaction attributes
+ * @buf: buffer with the data transferred
+ * @len: the maximum number of bytes to transfer
+ * @is_write: indicates the transfer direction
+ */
+MemTxResult address_space_rw_sg(AddressSpace *as,
+                                const ScatterGatherEntry *sg, int nsg,
+                                MemTxAttrs attrs, void *buf,
+                                hwaddr len, bool is_write);
+
 /**
  * address_space_write: write to address space.
  *
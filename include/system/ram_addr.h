@@ -463,17 +463,30 @@ static inline void cpu_physical_memory_dirty_bits_cleared(ram_addr_t start,
     }
 
 }
+void qemu_ram_set_dirty_granularity(RAMBlock *rb, uint64_t granularity);
+void qemu_ram_set_dirty_hold(RAMBlock *rb, unsigned snapshots);
+uint8_t cpu_physical_memory_set_dirty_subpage(ram_addr_t start,
+                                              ram_addr_t length,
+                                              uint8_t mask);
+
 bool cpu_physical_memory_test_and_clear_dirty(ram_addr_t start,
                                               ram_addr_t length,
                                               unsigned client);
 
 DirtyBitmapSnapshot *cpu_physical_memory_snapshot_and_clear_dirty
-    (MemoryRegion *mr, hwaddr offset, hwaddr length, unsigned client);
+    (MemoryRegion *mr, hwaddr offset, hwaddr length, unsigned client,
+     DirtyBitmapSnapshot *snap);
 
 bool cpu_physical_memory_snapshot_get_dirty(DirtyBitmapSnapshot *snap,
                                             ram_addr_t start,
                                             ram_addr_t length);
 
+bool cpu_physical_memory_snapshot_next_dirty(DirtyBitmapSnapshot *snap,
+                                             ram_addr_t start,
+                                             ram_addr_t end,
+                                             ram_addr_t *span_start,
+                                             ram_addr_t *span_end);
+
 static inline void cpu_physical_memory_clear_dirty_range(ram_addr_t start,
                                                          ram_addr_t length)
 {
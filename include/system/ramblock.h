@@ -89,6 +89,28 @@ struct RAMBlock {
      * could not have been valid on the source.
      */
     ram_addr_t postcopy_length;
+
+    /*
+     * Optional sub-page DIRTY_MEMORY_VGA tracking for TCG stores, see
+     * memory_region_set_dirty_granularity().  Bit n of @subpage_dirty
+     * covers bytes [n << subpage_shift, (n + 1) << subpage_shift) of the
+     * block; @subpage_writes counts the tracked stores to each page since
+     * it was last cleared.  Both are NULL when tracking is page-granular.
+     */
+    unsigned long *subpage_dirty;
+    uint8_t *subpage_writes;
+    uint8_t subpage_shift;
+
+    /*
+     * Optional held DIRTY_MEMORY_VGA pages, see
+     * memory_region_set_dirty_hold().  @dirty_gen counts the snapshots
+     * taken of the block; @dirty_page_gen holds, for each page, the
+     * generation it was first found dirty in, or 0 if it is clean.
+     * Protected by the BQL.
+     */
+    uint32_t *dirty_page_gen;
+    uint32_t dirty_gen;
+    unsigned dirty_hold;
 };
 
 #endif
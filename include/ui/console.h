@@ -396,6 +396,9 @@ QemuConsole *qemu_console_lookup_by_index(unsigned int index);
 QemuConsole *qemu_console_lookup_by_device(DeviceState *dev, uint32_t head);
 QemuConsole *qemu_console_lookup_by_device_name(const char *device_id,
                                                 uint32_t head, Error **errp);
+QemuConsole *qemu_console_lookup_by_qmp_args(const char *device,
+                                             bool has_head, int64_t head,
+                                             Error **errp);
 QEMUCursor *qemu_console_get_cursor(QemuConsole *con);
 bool qemu_console_is_visible(QemuConsole *con);
 bool qemu_console_is_graphic(QemuConsole *con);
@@ -413,6 +416,16 @@ void qemu_console_set_window_id(QemuConsole *con, int window_id);
 
 void qemu_console_resize(QemuConsole *con, int width, int height);
 DisplaySurface *qemu_console_surface(QemuConsole *con);
+
+/*
+ * Damage tracking: every dpy_gfx_update() bumps the console generation
+ * and stamps the QEMU_CONSOLE_TILE_SIZE square tiles it covers with it,
+ * so that a consumer can find out what changed since a generation it
+ * saw before.  Replacing the surface marks every tile as changed.
+ */
+#define QEMU_CONSOLE_TILE_SIZE 64
+uint64_t qemu_console_get_damage_generation(QemuConsole *con);
+uint64_t qemu_console_get_tile_generation(QemuConsole *con, int tx, int ty);
 void coroutine_fn qemu_console_co_wait_update(QemuConsole *con);
 int qemu_invalidate_text_consoles(void);
 
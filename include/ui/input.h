@@ -15,17 +15,44 @@
 #define INPUT_EVENT_SLOTS_MIN  0x0
 #define INPUT_EVENT_SLOTS_MAX  0xa
 
+#define INPUT_POINTER_SLOT_MOUSE  (-1)
+
 typedef struct QemuInputHandler QemuInputHandler;
 typedef struct QemuInputHandlerState QemuInputHandlerState;
 
+/*
+ * Complete state of an absolute pointer or of one multi-touch slot.
+ *
+ * @slot is INPUT_POINTER_SLOT_MOUSE for the mouse pointer, @type and
+ * @tracking_id are only meaningful for touch slots.  @x and @y are
+ * scaled to INPUT_EVENT_ABS_MIN..INPUT_EVENT_ABS_MAX.  @buttons and
+ * @buttons_changed have one bit per InputButton.  @timestamp is the
+ * QEMU_CLOCK_REALTIME time at which the frontend received the event,
+ * or 0 if unknown; it is only used for tracing.
+ */
+typedef struct QemuInputPointer {
+    int                  slot;
+    InputMultiTouchType  type;
+    int                  tracking_id;
+    int                  x;
+    int                  y;
+    uint32_t             buttons;
+    uint32_t             buttons_changed;
+    int64_t              timestamp;
+} QemuInputPointer;
+
 typedef void (*QemuInputHandlerEvent)(DeviceState *dev, QemuConsole *src,
                                       InputEvent *evt);
+typedef void (*QemuInputHandlerPointer)(DeviceState *dev, QemuConsole *src,
+                                        const QemuInputPointer *ptr);
 typedef void (*QemuInputHandlerSync)(DeviceState *dev);
 
 struct QemuInputHandler {
     const char             *name;
     uint32_t               mask;
     QemuInputHandlerEvent  event;
+    /* optional, receives qemu_input_send_pointer() in one call */
+    QemuInputHandlerPointer pointer;
     QemuInputHandlerSync   sync;
 };
 
@@ -69,6 +96,8 @@ void qemu_input_queue_mtt(QemuConsole *src, InputMultiTouchType type, int slot,
 void qemu_input_queue_mtt_abs(QemuConsole *src, InputAxis axis, int value,
                               int min_in, int max_in,
                               int slot, int tracking_id);
+uint32_t qemu_input_map_buttons(uint32_t *button_map, uint32_t mask);
+void qemu_input_send_pointer(QemuConsole *src, const QemuInputPointer *ptr);
 
 void qemu_input_check_mode_change(void);
 void qemu_add_mouse_mode_change_notifier(Notifier *notify);
@@ -54,4 +54,47 @@ static inline bool qemu_rect_intersect(const QemuRect *a, const QemuRect *b,
     return true;
 }
 
+/*
+ * Add a damaged area to a list of at most @max rects.  Areas already
+ * covered by an entry are dropped; once the list is full everything is
+ * collapsed into a single bounding box.
+ */
+static inline void qemu_rect_list_add(QemuRect *rects, int *nr_rects, int max,
+                                      int x, int y, int w, int h)
+{
+    int x1, y1, x2, y2;
+    int i;
+
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    for (i = 0; i < *nr_rects; i++) {
+        QemuRect *r = &rects[i];
+
+        if (x >= r->x && y >= r->y &&
+            x + w <= r->x + r->width && y + h <= r->y + r->height) {
+            return;
+        }
+    }
+
+    if (*nr_rects < max) {
+        qemu_rect_init(&rects[(*nr_rects)++], x, y, w, h);
+        return;
+    }
+
+    x1 = x;
+    y1 = y;
+    x2 = x + w;
+    y2 = y + h;
+    for (i = 0; i < *nr_rects; i++) {
+        x1 = MIN(x1, rects[i].x);
+        y1 = MIN(y1, rects[i].y);
+        x2 = MAX(x2, rects[i].x + rects[i].width);
+        y2 = MAX(y2, rects[i].y + rects[i].height);
+    }
+    qemu_rect_init(&rects[0], x1, y1, x2 - x1, y2 - y1);
+    *nr_rects = 1;
+}
+
 #endif
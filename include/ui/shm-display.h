@@ -0,0 +1,55 @@
+/*
+ * Shared-memory framebuffer export: memory layout
+ *
+ * This header describes the layout of the file written by the
+ * "display-shm" object.  It is meant to be usable from a viewer
+ * process as well, so it only depends on fixed-width integer types.
+ *
+ * The file starts with a QemuShmDisplayHeader, pixel data follows at
+ * @data_offset.  @generation works like a sequence lock: it is odd
+ * while QEMU updates the pixels or the header, and even once a frame
+ * has been published.  A reader samples @generation, copies what it
+ * needs, and retries if @generation was odd or changed meanwhile.
+ *
+ * @rects lists the areas that changed between generation - 2 and
+ * generation.  A reader that skipped a generation must treat the
+ * whole frame as changed.
+ *
+ * The file only ever grows; after a mode change (@width, @height or
+ * @stride differ from what the reader last saw) the reader should
+ * re-map the file.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.  See the COPYING file in the
+ * top-level directory.
+ */
+
+#ifndef UI_SHM_DISPLAY_H
+#define UI_SHM_DISPLAY_H
+
+#define QEMU_SHM_DISPLAY_MAGIC          0x4d485351 /* "QSHM" */
+#define QEMU_SHM_DISPLAY_VERSION        1
+#define QEMU_SHM_DISPLAY_MAX_RECTS      32
+#define QEMU_SHM_DISPLAY_DATA_OFFSET    4096
+
+typedef struct QemuShmDisplayRect {
+    uint32_t x;
+    uint32_t y;
+    uint32_t w;
+    uint32_t h;
+} QemuShmDisplayRect;
+
+typedef struct QemuShmDisplayHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t generation;
+    uint32_t format;        /* pixman_format_code_t, always x8r8g8b8 */
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t data_offset;
+    uint32_t nr_rects;
+    QemuShmDisplayRect rects[QEMU_SHM_DISPLAY_MAX_RECTS];
+} QemuShmDisplayHeader;
+
+#endif /* UI_SHM_DISPLAY_H */
@@ -228,6 +228,7 @@ DEF("accel", HAS_ARG, QEMU_OPTION_accel,
     "                one-insn-per-tb=on|off (one guest instruction per TCG translation block)\n"
     "                split-wx=on|off (enable TCG split w^x mapping)\n"
     "                tb-size=n (TCG translation block cache size)\n"
+    "                idle-warp=on|off (skip virtual time while all TCG vCPUs are idle, default=off)\n"
     "                dirty-ring-size=n (KVM dirty ring GFN count, default 0)\n"
     "                eager-split-size=n (KVM Eager Page Split chunk size, default 0, disabled. ARM only)\n"
     "                notify-vmexit=run|internal-error|disable,notify-window=n (enable notify VM exit and set notify window, x86 only)\n"
@@ -271,6 +272,15 @@ SRST
     ``tb-size=n``
         Controls the size (in MiB) of the TCG translation block cache.
 
+    ``idle-warp=on|off``
+        When every TCG vCPU is idle (e.g. halted in WFI), advance the
+        virtual clock straight to the next timer deadline instead of
+        waiting for it in real time. This is the equivalent of
+        ``-icount sleep=off`` for guests that run without icount, and
+        keeps multi-threaded TCG available. Virtual time no longer
+        tracks real time, so this is mostly useful for timer-bound test
+        workloads. It cannot be used with icount. The default is off.
+
     ``thread=single|multi``
         Controls number of TCG threads. When the TCG is multi-threaded
         there will be one thread per vCPU therefore taking advantage of
@@ -5548,6 +5558,20 @@ SRST
         parameter is the unique ID of a character device backend that
         provides the connection to the RNG daemon.
 
+    ``-object display-shm,id=id,path=path[,device=dev[,head=head]][,chardev=chardevid]``
+        Publishes the contents of a graphic console into the host file
+        ``path``, usually on a tmpfs such as ``/dev/shm``, so that local
+        viewers can map it and read frames without a VNC connection.
+        The file starts with a header holding a generation counter, the
+        pixel format and the list of rectangles changed by the last
+        frame, followed by the pixels; see ``include/ui/shm-display.h``
+        for the layout. It works with any ``-display`` option, including
+        ``-display none``. ``device`` and ``head`` select the console as
+        for ``screendump``; the primary display is used by default. If
+        ``chardev`` is given, the 32-bit little-endian generation number
+        of every published frame is written to it, so that a viewer can
+        wait on a socket instead of polling the header.
+
     ``-object tls-creds-anon,id=id,endpoint=endpoint,dir=/path/to/cred/dir,verify-peer=on|off``
         Creates a TLS anonymous credentials object, which can be used to
         provide TLS support on network backends. The ``id`` parameter is
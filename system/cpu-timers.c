@@ -33,6 +33,7 @@
 #include "qemu/seqlock.h"
 #include "system/replay.h"
 #include "system/runstate.h"
+#include "system/qtest.h"
 #include "hw/core/cpu.h"
 #include "system/cpu-timers.h"
 #include "system/cpu-timers-internal.h"
@@ -135,6 +136,57 @@ void cpu_disable_ticks(void)
                          &timers_state.vm_clock_lock);
 }
 
+static bool idle_warp;
+
+void cpu_set_idle_warp(bool enable)
+{
+    idle_warp = enable;
+}
+
+bool cpu_idle_warp_enabled(void)
+{
+    return idle_warp;
+}
+
+/*
+ * Advance QEMU_CLOCK_VIRTUAL to the next deadline if no vCPU can make
+ * progress before it. This is the non-icount counterpart of
+ * icount_start_warp_timer() with sleep=off: the jump is applied to
+ * cpu_clock_offset, so the clock stays monotonic and migrates as usual.
+ * Caller must hold BQL.
+ */
+void cpu_idle_warp(void)
+{
+    int64_t deadline;
+
+    if (!idle_warp || icount_enabled() || replay_mode != REPLAY_MODE_NONE) {
+        return;
+    }
+    /* qtest drives QEMU_CLOCK_VIRTUAL itself */
+    if (qtest_enabled() || !runstate_is_running()) {
+        return;
+    }
+    if (!all_cpu_threads_idle()) {
+        return;
+    }
+
+    deadline = qemu_clock_deadline_ns_all(QEMU_CLOCK_VIRTUAL,
+                                          ~QEMU_TIMER_ATTR_EXTERNAL);
+    if (deadline <= 0) {
+        /* Either a timer is already due, or only an I/O event can help */
+        return;
+    }
+
+    seqlock_write_lock(&timers_state.vm_clock_seqlock,
+                       &timers_state.vm_clock_lock);
+    if (timers_state.cpu_ticks_enabled) {
+        timers_state.cpu_clock_offset += deadline;
+    }
+    seqlock_write_unlock(&timers_state.vm_clock_seqlock,
+                         &timers_state.vm_clock_lock);
+    qemu_clock_notify(QEMU_CLOCK_VIRTUAL);
+}
+
 static bool icount_state_needed(void *opaque)
 {
     return icount_enabled();
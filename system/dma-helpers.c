@@ -279,25 +279,15 @@ static MemTxResult dma_buf_rw(void *buf, dma_addr_t len, dma_addr_t *residual,
                               QEMUSGList *sg, DMADirection dir,
                               MemTxAttrs attrs)
 {
-    uint8_t *ptr = buf;
-    dma_addr_t xresidual;
-    int sg_cur_index;
-    MemTxResult res = MEMTX_OK;
-
-    xresidual = sg->size;
-    sg_cur_index = 0;
-    len = MIN(len, xresidual);
-    while (len > 0) {
-        ScatterGatherEntry entry = sg->sg[sg_cur_index++];
-        dma_addr_t xfer = MIN(len, entry.len);
-        res |= dma_memory_rw(sg->as, entry.base, ptr, xfer, dir, attrs);
-        ptr += xfer;
-        len -= xfer;
-        xresidual -= xfer;
-    }
+    MemTxResult res;
+
+    len = MIN(len, sg->size);
+    dma_barrier(sg->as, dir);
+    res = address_space_rw_sg(sg->as, sg->sg, sg->nsg, attrs, buf, len,
+                              dir == DMA_DIRECTION_FROM_DEVICE);
 
     if (residual) {
-        *residual = xresidual;
+        *residual = sg->size - len;
     }
     return res;
 }
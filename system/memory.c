@@ -2262,6 +2262,19 @@ void memory_region_set_log(MemoryRegion *mr, bool log, unsigned client)
     memory_region_transaction_commit();
 }
 
+void memory_region_set_dirty_granularity(MemoryRegion *mr,
+                                         uint64_t granularity)
+{
+    assert(mr->ram_block);
+    qemu_ram_set_dirty_granularity(mr->ram_block, granularity);
+}
+
+void memory_region_set_dirty_hold(MemoryRegion *mr, unsigned snapshots)
+{
+    assert(mr->ram_block);
+    qemu_ram_set_dirty_hold(mr->ram_block, snapshots);
+}
+
 void memory_region_set_dirty(MemoryRegion *mr, hwaddr addr,
                              hwaddr size)
 {
@@ -2367,12 +2380,22 @@ DirtyBitmapSnapshot *memory_region_snapshot_and_clear_dirty(MemoryRegion *mr,
                                                             hwaddr size,
                                                             unsigned client)
 {
-    DirtyBitmapSnapshot *snapshot;
+    return memory_region_snapshot_and_clear_dirty_reuse(mr, addr, size,
+                                                        client, NULL);
+}
+
+DirtyBitmapSnapshot *
+memory_region_snapshot_and_clear_dirty_reuse(MemoryRegion *mr,
+                                             hwaddr addr, hwaddr size,
+                                             unsigned client,
+                                             DirtyBitmapSnapshot *snap)
+{
     assert(mr->ram_block);
     memory_region_sync_dirty_bitmap(mr, false);
-    snapshot = cpu_physical_memory_snapshot_and_clear_dirty(mr, addr, size, client);
+    snap = cpu_physical_memory_snapshot_and_clear_dirty(mr, addr, size,
+                                                        client, snap);
     memory_global_after_dirty_log_sync();
-    return snapshot;
+    return snap;
 }
 
 bool memory_region_snapshot_get_dirty(MemoryRegion *mr, DirtyBitmapSnapshot *snap,
@@ -2383,6 +2406,24 @@ bool memory_region_snapshot_get_dirty(MemoryRegion *mr, DirtyBitmapSnapshot *sna
                 memory_region_get_ram_addr(mr) + addr, size);
 }
 
+bool memory_region_snapshot_next_dirty(MemoryRegion *mr,
+                                       DirtyBitmapSnapshot *snap,
+                                       hwaddr addr, hwaddr end,
+                                       hwaddr *span_start, hwaddr *span_end)
+{
+    ram_addr_t base, start, last;
+
+    assert(mr->ram_block);
+    base = memory_region_get_ram_addr(mr);
+    if (!cpu_physical_memory_snapshot_next_dirty(snap, base + addr,
+                                                 base + end, &start, &last)) {
+        return false;
+    }
+    *span_start = start - base;
+    *span_end = last - base;
+    return true;
+}
+
 void memory_region_set_readonly(MemoryRegion *mr, bool readonly)
 {
     if (mr->readonly != readonly) {
@@ -178,6 +178,10 @@ typedef struct CPUAddressSpace {
 struct DirtyBitmapSnapshot {
     ram_addr_t start;
     ram_addr_t end;
+    /* log2 of the bytes covered by each bit of @dirty */
+    unsigned shift;
+    /* Number of bits @dirty has room for, for reuse */
+    unsigned long capacity;
     unsigned long dirty[];
 };
 
@@ -918,6 +922,20 @@ bool cpu_physical_memory_test_and_clear_dirty(ram_addr_t start,
         mr_offset = (ram_addr_t)(start_page << TARGET_PAGE_BITS) - ramblock->offset;
         mr_size = (end - start_page) << TARGET_PAGE_BITS;
         memory_region_clear_dirty_bitmap(ramblock->mr, mr_offset, mr_size);
+
+        if (client == DIRTY_MEMORY_VGA && ramblock->subpage_dirty) {
+            unsigned shift = ramblock->subpage_shift;
+
+            dirty |= bitmap_test_and_clear_atomic(ramblock->subpage_dirty,
+                                                  mr_offset >> shift,
+                                                  mr_size >> shift);
+            memset(ramblock->subpage_writes + (mr_offset >> TARGET_PAGE_BITS),
+                   0, mr_size >> TARGET_PAGE_BITS);
+        }
+        if (client == DIRTY_MEMORY_VGA && ramblock->dirty_page_gen) {
+            memset(ramblock->dirty_page_gen + (mr_offset >> TARGET_PAGE_BITS),
+                   0, (mr_size >> TARGET_PAGE_BITS) * sizeof(uint32_t));
+        }
     }
 
     if (dirty) {
@@ -927,14 +945,196 @@ bool cpu_physical_memory_test_and_clear_dirty(ram_addr_t start,
     return dirty;
 }
 
+/*
+ * Number of stores a page with sub-page tracking takes through the slow
+ * path before it is simply marked dirty as a whole.  Small updates are
+ * tracked precisely; bulk redraws only pay for a few slow stores per page.
+ */
+#define SUBPAGE_DIRTY_MAX_WRITES 16
+
+void qemu_ram_set_dirty_granularity(RAMBlock *rb, uint64_t granularity)
+{
+    unsigned shift, min_shift;
+    unsigned long nr_pages;
+
+    /* All sub-page bits of a page have to fit in one bitmap word */
+    min_shift = TARGET_PAGE_BITS - BITS_PER_LEVEL;
+    shift = MAX(granularity ? ctz64(pow2ceil(granularity)) : TARGET_PAGE_BITS,
+                min_shift);
+    if (shift >= TARGET_PAGE_BITS || rb->subpage_dirty) {
+        return;
+    }
+
+    nr_pages = DIV_ROUND_UP(rb->max_length, TARGET_PAGE_SIZE);
+    rb->subpage_shift = shift;
+    rb->subpage_writes = g_new0(uint8_t, nr_pages);
+    qatomic_rcu_set(&rb->subpage_dirty,
+                    bitmap_new(nr_pages << (TARGET_PAGE_BITS - shift)));
+    qatomic_inc(&ram_list.num_subpage_dirty);
+}
+
+/*
+ * Record a TCG store to [@start, @start + @length), which lies within a
+ * single page, in the sub-page bitmap of its RAMBlock.  Returns the dirty
+ * clients for which the whole page still has to be marked dirty: @mask
+ * without DIRTY_MEMORY_VGA, until the page has seen enough stores that
+ * tracking it precisely is not worth the slow path any more.
+ */
+uint8_t cpu_physical_memory_set_dirty_subpage(ram_addr_t start,
+                                              ram_addr_t length,
+                                              uint8_t mask)
+{
+    RAMBlock *rb;
+    unsigned long *bmap, first, last;
+    uint8_t *writes;
+
+    if (!(mask & (1 << DIRTY_MEMORY_VGA)) ||
+        !qatomic_read(&ram_list.num_subpage_dirty)) {
+        return mask;
+    }
+
+    RCU_READ_LOCK_GUARD();
+    rb = qemu_get_ram_block(start);
+    bmap = qatomic_rcu_read(&rb->subpage_dirty);
+    if (!bmap) {
+        return mask;
+    }
+
+    start -= rb->offset;
+    first = start >> rb->subpage_shift;
+    last = (start + length - 1) >> rb->subpage_shift;
+    bitmap_set_atomic(bmap, first, last - first + 1);
+
+    /* Racy, but this is only a heuristic */
+    writes = &rb->subpage_writes[start >> TARGET_PAGE_BITS];
+    if (qatomic_read(writes) < SUBPAGE_DIRTY_MAX_WRITES) {
+        qatomic_set(writes, qatomic_read(writes) + 1);
+        mask &= ~(1 << DIRTY_MEMORY_VGA);
+    }
+    return mask;
+}
+
+void qemu_ram_set_dirty_hold(RAMBlock *rb, unsigned snapshots)
+{
+    if (snapshots < 2 || rb->dirty_page_gen) {
+        return;
+    }
+    rb->dirty_hold = snapshots;
+    rb->dirty_gen = 1;
+    rb->dirty_page_gen = g_new0(uint32_t,
+                                DIV_ROUND_UP(rb->max_length, TARGET_PAGE_SIZE));
+}
+
+/*
+ * With held dirty pages, the DIRTY_MEMORY_VGA bits of @rb have been copied
+ * into @snap without clearing them.  Start a new generation, and clear the
+ * bits of the pages that have now been reported dirty for @rb->dirty_hold
+ * generations, so that the next store to them is trapped again.  Until
+ * then their TLB entries stay on the fast path: a page that the guest
+ * redraws continuously only takes the notdirty slow path once every
+ * @rb->dirty_hold refreshes rather than on every one.
+ *
+ * Returns the range of pages whose bits were cleared in [*rearm_first,
+ * *rearm_last), which is empty if there are none.
+ */
+static void snapshot_hold_dirty(DirtyBitmapSnapshot *snap, RAMBlock *rb,
+                                DirtyMemoryBlocks *blocks,
+                                ram_addr_t *rearm_first,
+                                ram_addr_t *rearm_last)
+{
+    ram_addr_t snap_page = snap->start >> TARGET_PAGE_BITS;
+    ram_addr_t rb_page = rb->offset >> TARGET_PAGE_BITS;
+    ram_addr_t rb_end = rb_page + DIV_ROUND_UP(rb->used_length,
+                                               TARGET_PAGE_SIZE);
+    unsigned long p, lim;
+    uint32_t gen;
+
+    *rearm_first = *rearm_last = 0;
+
+    gen = ++rb->dirty_gen;
+    if (!gen) {
+        gen = rb->dirty_gen = 1;
+    }
+
+    p = MAX(rb_page, snap_page) - snap_page;
+    lim = MIN(rb_end, (ram_addr_t)(snap->end >> TARGET_PAGE_BITS)) -
+          snap_page;
+    for (p = find_next_bit(snap->dirty, lim, p); p < lim;
+         p = find_next_bit(snap->dirty, lim, p + 1)) {
+        ram_addr_t page = snap_page + p;
+        uint32_t *page_gen = &rb->dirty_page_gen[page - rb_page];
+
+        if (!*page_gen) {
+            *page_gen = gen;
+            continue;
+        }
+        if (gen - *page_gen < rb->dirty_hold) {
+            continue;
+        }
+        *page_gen = 0;
+        clear_bit_atomic(page % DIRTY_MEMORY_BLOCK_SIZE,
+                         blocks->blocks[page / DIRTY_MEMORY_BLOCK_SIZE]);
+        if (*rearm_first == *rearm_last) {
+            *rearm_first = page;
+        }
+        *rearm_last = page + 1;
+    }
+}
+
+/*
+ * Expand the page-granular bitmap at the start of @snap->dirty, in place,
+ * to the sub-page granularity of @rb.  Pages that are dirty as a whole
+ * become entirely dirty; the others take the sub-page bits recorded by
+ * cpu_physical_memory_set_dirty_subpage().  Either way the sub-page state
+ * of the page is cleared.
+ */
+static void snapshot_expand_subpage(DirtyBitmapSnapshot *snap, RAMBlock *rb)
+{
+    unsigned k = 1U << (TARGET_PAGE_BITS - rb->subpage_shift);
+    unsigned long kmask = k == BITS_PER_LONG ? ~0UL : (1UL << k) - 1;
+    unsigned long nr_pages = (snap->end - snap->start) >> TARGET_PAGE_BITS;
+    ram_addr_t snap_page = snap->start >> TARGET_PAGE_BITS;
+    ram_addr_t rb_page = rb->offset >> TARGET_PAGE_BITS;
+    ram_addr_t rb_pages = DIV_ROUND_UP(rb->used_length, TARGET_PAGE_SIZE);
+    unsigned long *bmap = rb->subpage_dirty;
+    long p;
+
+    /*
+     * Going backwards, the k bits written for page p never overlap the
+     * page bits of pages below p that are still to be read.
+     */
+    for (p = nr_pages - 1; p >= 0; p--) {
+        ram_addr_t page = snap_page + p;
+        unsigned long bits = 0, dst = p * k;
+
+        if (page >= rb_page && page < rb_page + rb_pages) {
+            unsigned long src = (page - rb_page) * k;
+            unsigned long src_mask = kmask << (src % BITS_PER_LONG);
+
+            bits = qatomic_fetch_and(&bmap[BIT_WORD(src)], ~src_mask);
+            bits = (bits & src_mask) >> (src % BITS_PER_LONG);
+            qatomic_set(&rb->subpage_writes[page - rb_page], 0);
+        }
+        if (test_bit(p, snap->dirty)) {
+            bits = kmask;
+        }
+        snap->dirty[BIT_WORD(dst)] &= ~(kmask << (dst % BITS_PER_LONG));
+        snap->dirty[BIT_WORD(dst)] |= bits << (dst % BITS_PER_LONG);
+    }
+    snap->shift = rb->subpage_shift;
+}
+
 DirtyBitmapSnapshot *cpu_physical_memory_snapshot_and_clear_dirty
-    (MemoryRegion *mr, hwaddr offset, hwaddr length, unsigned client)
+    (MemoryRegion *mr, hwaddr offset, hwaddr length, unsigned client,
+     DirtyBitmapSnapshot *snap)
 {
+    RAMBlock *rb = mr->ram_block;
+    bool subpage = client == DIRTY_MEMORY_VGA && rb->subpage_dirty;
+    bool hold = client == DIRTY_MEMORY_VGA && rb->dirty_page_gen;
     DirtyMemoryBlocks *blocks;
-    ram_addr_t start, first, last;
+    ram_addr_t start, first, last, rearm_first = 0, rearm_last = 0;
     unsigned long align = 1UL << (TARGET_PAGE_BITS + BITS_PER_LEVEL);
-    DirtyBitmapSnapshot *snap;
-    unsigned long page, end, dest;
+    unsigned long page, end, dest, nr_bits;
 
     start = memory_region_get_ram_addr(mr);
     /* We know we're only called for RAM MemoryRegions */
@@ -944,10 +1144,21 @@ DirtyBitmapSnapshot *cpu_physical_memory_snapshot_and_clear_dirty
     first = QEMU_ALIGN_DOWN(start, align);
     last  = QEMU_ALIGN_UP(start + length, align);
 
-    snap = g_malloc0(sizeof(*snap) +
-                     ((last - first) >> (TARGET_PAGE_BITS + 3)));
+    /*
+     * Every word of the bitmap is overwritten below, so a buffer that is
+     * large enough can be reused as is.
+     */
+    nr_bits = (last - first) >> (subpage ? rb->subpage_shift
+                                         : TARGET_PAGE_BITS);
+    if (!snap || snap->capacity < nr_bits) {
+        g_free(snap);
+        snap = g_malloc(sizeof(*snap) +
+                        BITS_TO_LONGS(nr_bits) * sizeof(unsigned long));
+        snap->capacity = nr_bits;
+    }
     snap->start = first;
     snap->end   = last;
+    snap->shift = TARGET_PAGE_BITS;
 
     page = first >> TARGET_PAGE_BITS;
     end  = last  >> TARGET_PAGE_BITS;
@@ -966,17 +1177,47 @@ DirtyBitmapSnapshot *cpu_physical_memory_snapshot_and_clear_dirty
             assert(QEMU_IS_ALIGNED(num,    (1 << BITS_PER_LEVEL)));
             ofs >>= BITS_PER_LEVEL;
 
-            bitmap_copy_and_clear_atomic(snap->dirty + dest,
-                                         blocks->blocks[idx] + ofs,
-                                         num);
+            if (hold) {
+                unsigned long i;
+
+                for (i = 0; i < num >> BITS_PER_LEVEL; i++) {
+                    snap->dirty[dest + i] =
+                        qatomic_read(&blocks->blocks[idx][ofs + i]);
+                }
+            } else {
+                bitmap_copy_and_clear_atomic(snap->dirty + dest,
+                                             blocks->blocks[idx] + ofs,
+                                             num);
+            }
             page += num;
             dest += num >> BITS_PER_LEVEL;
         }
+
+        if (hold) {
+            snapshot_hold_dirty(snap, rb, blocks, &rearm_first, &rearm_last);
+        }
+    }
+
+    if (subpage) {
+        snapshot_expand_subpage(snap, rb);
     }
 
-    cpu_physical_memory_dirty_bits_cleared(start, length);
+    if (!hold) {
+        cpu_physical_memory_dirty_bits_cleared(start, length);
+        memory_region_clear_dirty_bitmap(mr, offset, length);
+    } else if (rearm_first != rearm_last) {
+        /*
+         * Only the pages that were re-armed need to leave the fast path,
+         * and only their bits have been cleared: the held pages stay
+         * dirty, so their dirty log must not be cleared either.
+         */
+        ram_addr_t rearm_start = rearm_first << TARGET_PAGE_BITS;
+        ram_addr_t rearm_len = (rearm_last - rearm_first) << TARGET_PAGE_BITS;
 
-    memory_region_clear_dirty_bitmap(mr, offset, length);
+        cpu_physical_memory_dirty_bits_cleared(rearm_start, rearm_len);
+        memory_region_clear_dirty_bitmap(mr, rearm_start - (start - offset),
+                                         rearm_len);
+    }
 
     return snap;
 }
@@ -990,8 +1231,9 @@ bool cpu_physical_memory_snapshot_get_dirty(DirtyBitmapSnapshot *snap,
     assert(start >= snap->start);
     assert(start + length <= snap->end);
 
-    end = TARGET_PAGE_ALIGN(start + length - snap->start) >> TARGET_PAGE_BITS;
-    page = (start - snap->start) >> TARGET_PAGE_BITS;
+    end = ROUND_UP(start + length - snap->start, 1ULL << snap->shift)
+          >> snap->shift;
+    page = (start - snap->start) >> snap->shift;
 
     while (page < end) {
         if (test_bit(page, snap->dirty)) {
@@ -1002,6 +1244,36 @@ bool cpu_physical_memory_snapshot_get_dirty(DirtyBitmapSnapshot *snap,
     return false;
 }
 
+bool cpu_physical_memory_snapshot_next_dirty(DirtyBitmapSnapshot *snap,
+                                             ram_addr_t start,
+                                             ram_addr_t end,
+                                             ram_addr_t *span_start,
+                                             ram_addr_t *span_end)
+{
+    unsigned long page, last, next;
+
+    assert(start >= snap->start);
+    assert(end <= snap->end);
+
+    if (start >= end) {
+        return false;
+    }
+
+    page = (start - snap->start) >> snap->shift;
+    last = ROUND_UP(end - snap->start, 1ULL << snap->shift) >> snap->shift;
+
+    /* Both searches skip a whole word (BITS_PER_LONG bits) at a time */
+    page = find_next_bit(snap->dirty, last, page);
+    if (page >= last) {
+        return false;
+    }
+    next = find_next_zero_bit(snap->dirty, last, page + 1);
+
+    *span_start = MAX(start, snap->start + ((ram_addr_t)page << snap->shift));
+    *span_end = MIN(end, snap->start + ((ram_addr_t)next << snap->shift));
+    return true;
+}
+
 /* Called from RCU critical section */
 hwaddr memory_region_section_get_iotlb(CPUState *cpu,
                                        MemoryRegionSection *section)
@@ -2269,6 +2541,13 @@ static void reclaim_ramblock(RAMBlock *block)
         ram_block_discard_require(false);
     }
 
+    if (block->subpage_dirty) {
+        qatomic_dec(&ram_list.num_subpage_dirty);
+        g_free(block->subpage_dirty);
+        g_free(block->subpage_writes);
+    }
+    g_free(block->dirty_page_gen);
+
     g_free(block);
 }
 
@@ -2686,6 +2965,52 @@ MemoryRegionSection *iotlb_to_section(CPUState *cpu,
     return ret;
 }
 
+MemoryRegionSection *iotlb_resolve_subpage(CPUState *cpu,
+                                           MemoryRegionSection *section,
+                                           MemTxAttrs attrs, hwaddr *offset,
+                                           unsigned size)
+{
+    subpage_t *subpage = container_of(section->mr, subpage_t, iomem);
+    AddressSpaceDispatch *d;
+    MemoryRegionSection *leaf;
+    MemoryRegion *mr;
+    hwaddr addr = *offset;
+    unsigned max_size, i;
+    uint16_t idx;
+
+    if (!is_power_of_2(size) || (addr & (size - 1)) ||
+        addr + size > TARGET_PAGE_SIZE) {
+        return section;
+    }
+    idx = subpage->sub_section[SUBPAGE_IDX(addr)];
+    for (i = 1; i < size; i++) {
+        if (subpage->sub_section[SUBPAGE_IDX(addr + i)] != idx) {
+            return section;
+        }
+    }
+
+    d = cpu->cpu_ases[cpu_asidx_from_attrs(cpu, attrs)].memory_dispatch;
+    leaf = &d->map.sections[idx];
+    mr = leaf->mr;
+
+    /*
+     * RAM, ROM devices and IOMMUs need flatview_read/write.  So does an
+     * access that flatview_read_continue would split into smaller ones.
+     */
+    if (memory_region_is_ram(mr) || memory_region_is_romd(mr) ||
+        memory_region_get_iommu(mr)) {
+        return section;
+    }
+    max_size = mr->ops->valid.max_access_size ?: 4;
+    if (size > max_size || size < mr->ops->valid.min_access_size) {
+        return section;
+    }
+
+    *offset = subpage->base + addr - leaf->offset_within_address_space
+              + leaf->offset_within_region;
+    return leaf;
+}
+
 static void io_mem_init(void)
 {
     memory_region_init_io(&io_mem_unassigned, NULL, &unassigned_mem_ops, NULL,
@@ -2849,6 +3174,13 @@ void memory_region_flush_rom_device(MemoryRegion *mr, hwaddr addr, hwaddr size)
     invalidate_and_set_dirty(mr, addr, size);
 }
 
+void memory_region_flush_ram(MemoryRegion *mr, hwaddr addr, hwaddr size)
+{
+    assert(memory_access_is_direct(mr, true, MEMTXATTRS_UNSPECIFIED));
+
+    invalidate_and_set_dirty(mr, addr, size);
+}
+
 int memory_access_size(MemoryRegion *mr, unsigned l, hwaddr addr)
 {
     unsigned access_size_max = mr->ops->valid.max_access_size;
@@ -3146,6 +3478,36 @@ MemTxResult address_space_rw(AddressSpace *as, hwaddr addr, MemTxAttrs attrs,
     }
 }
 
+MemTxResult address_space_rw_sg(AddressSpace *as,
+                                const ScatterGatherEntry *sg, int nsg,
+                                MemTxAttrs attrs, void *buf,
+                                hwaddr len, bool is_write)
+{
+    MemTxResult result = MEMTX_OK;
+    uint8_t *ptr = buf;
+    FlatView *fv;
+    int i;
+
+    RCU_READ_LOCK_GUARD();
+    fv = address_space_to_flatview(as);
+    for (i = 0; i < nsg && len > 0; i++) {
+        hwaddr xfer = MIN(len, sg[i].len);
+
+        if (!xfer) {
+            continue;
+        }
+        if (is_write) {
+            result |= flatview_write(fv, sg[i].base, attrs, ptr, xfer);
+        } else {
+            result |= flatview_read(fv, sg[i].base, attrs, ptr, xfer);
+        }
+        ptr += xfer;
+        len -= xfer;
+    }
+
+    return result;
+}
+
 MemTxResult address_space_set(AddressSpace *as, hwaddr addr,
                               uint8_t c, hwaddr len, MemTxAttrs attrs)
 {
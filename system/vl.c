@@ -1959,6 +1959,7 @@ static bool object_create_early(const char *type)
 
     /* Reason: property "chardev" */
     if (g_str_equal(type, "rng-egd") ||
+        g_str_equal(type, "display-shm") ||
         g_str_equal(type, "qtest")) {
         return false;
     }
@@ -149,6 +149,18 @@ static bool arm_cpu_has_work(CPUState *cs)
          | CPU_INTERRUPT_VFIQ | CPU_INTERRUPT_VIRQ | CPU_INTERRUPT_VSERR
          | CPU_INTERRUPT_EXITTB);
 }
+
+/*
+ * Set the M-profile event register from outside the CPU's own
+ * execution (SEV on another CPU, SEVONPEND) and wake it up if it is
+ * sleeping in WFE.  CPU_INTERRUPT_EXITTB counts as work, so a CPU that
+ * is just about to halt will notice it too.
+ */
+void arm_v7m_send_event(ARMCPU *cpu)
+{
+    qatomic_set(&cpu->env.v7m.event_register, 1);
+    cpu_interrupt(CPU(cpu), CPU_INTERRUPT_EXITTB);
+}
 #endif /* !CONFIG_USER_ONLY */
 
 void arm_register_pre_el_change_hook(ARMCPU *cpu, ARMELChangeHookFn *hook,
@@ -505,6 +517,8 @@ static void arm_cpu_reset_hold(Object *obj, ResetType type)
                 memset(env->pmsav8.rlar[M_REG_NS], 0,
                        sizeof(*env->pmsav8.rlar[M_REG_NS])
                        * cpu->pmsav7_dregion);
+                env->pmsav8.seg_valid[M_REG_NS] = false;
+                env->pmsav8.seg_valid[M_REG_S] = false;
                 if (arm_feature(env, ARM_FEATURE_M_SECURITY)) {
                     memset(env->pmsav8.rbar[M_REG_S], 0,
                            sizeof(*env->pmsav8.rbar[M_REG_S])
@@ -520,6 +534,7 @@ static void arm_cpu_reset_hold(Object *obj, ResetType type)
                        sizeof(*env->pmsav7.drsr) * cpu->pmsav7_dregion);
                 memset(env->pmsav7.dracr, 0,
                        sizeof(*env->pmsav7.dracr) * cpu->pmsav7_dregion);
+                env->pmsav7.seg_valid = false;
             }
         }
 
@@ -1577,6 +1592,9 @@ static const Property arm_cpu_has_dsp_property =
 static const Property arm_cpu_has_mpu_property =
             DEFINE_PROP_BOOL("has-mpu", ARMCPU, has_mpu, true);
 
+static const Property arm_cpu_bulk_mem_property =
+            DEFINE_PROP_BOOL("x-bulk-mem", ARMCPU, bulk_mem, false);
+
 /* This is like DEFINE_PROP_UINT32 but it doesn't set the default value,
  * because the CPU initfn will have already set cpu->pmsav7_dregion to
  * the right value for that particular CPU type, and we don't want
@@ -1853,6 +1871,7 @@ void arm_cpu_post_init(Object *obj)
         object_property_add_uint32_ptr(obj, "init-nsvtor",
                                        &cpu->init_nsvtor,
                                        OBJ_PROP_FLAG_READWRITE);
+        qdev_property_add_static(DEVICE(obj), &arm_cpu_bulk_mem_property);
     }
 
     /* Not DEFINE_PROP_UINT32: we want this to be settable after realize */
@@ -2482,14 +2501,23 @@ static void arm_cpu_realizefn(DeviceState *dev, Error **errp)
                 /* PMSAv8 */
                 env->pmsav8.rbar[M_REG_NS] = g_new0(uint32_t, nr);
                 env->pmsav8.rlar[M_REG_NS] = g_new0(uint32_t, nr);
+                /* Each region adds at most two segment boundaries */
+                env->pmsav8.seg[M_REG_NS] = g_new0(ARMMPUSegment, 2 * nr + 1);
                 if (arm_feature(env, ARM_FEATURE_M_SECURITY)) {
                     env->pmsav8.rbar[M_REG_S] = g_new0(uint32_t, nr);
                     env->pmsav8.rlar[M_REG_S] = g_new0(uint32_t, nr);
+                    env->pmsav8.seg[M_REG_S] =
+                        g_new0(ARMMPUSegment, 2 * nr + 1);
                 }
             } else {
                 env->pmsav7.drbar = g_new0(uint32_t, nr);
                 env->pmsav7.drsr = g_new0(uint32_t, nr);
                 env->pmsav7.dracr = g_new0(uint32_t, nr);
+                /*
+                 * Each region adds at most two boundaries, plus seven
+                 * between its subregions
+                 */
+                env->pmsav7.seg = g_new0(ARMMPUSegment, 9 * nr + 1);
             }
         }
 
@@ -179,6 +179,20 @@ typedef struct ARMPACKey {
     uint64_t lo, hi;
 } ARMPACKey;
 
+/*
+ * One entry of an M-profile MPU lookup cache (PMSAv7 or PMSAv8): the
+ * addresses from @base up to the next entry's base all hit the same
+ * MPU region. @region is that region's number, or one of the MPU_SEG_*
+ * values if there is no such single region.
+ */
+#define MPU_SEG_NO_REGION -1
+#define MPU_SEG_MULTIPLE_REGIONS -2
+
+typedef struct ARMMPUSegment {
+    uint32_t base;
+    int32_t region;
+} ARMMPUSegment;
+
 /* See the commentary above the TBFLAG field definitions.  */
 typedef struct CPUARMTBFlags {
     uint32_t flags;
@@ -610,6 +624,22 @@ typedef struct CPUArchState {
         uint32_t nsacr;
         uint32_t ltpsize;
         uint32_t vpr;
+        uint32_t event_register; /* for WFE (not guest visible) */
+        /*
+         * Progress of an x-bulk-mem memcpy/memset call that was left to
+         * take a pending interrupt (not guest visible). Only the next call
+         * can resume it, if it has the same entry point, arguments, stack
+         * pointer and return address. Not migrated: losing it only makes
+         * the call start over.
+         */
+        struct {
+            bool valid;
+            uint32_t pc;
+            uint32_t sp;
+            uint32_t lr;
+            uint32_t args[3];
+            uint32_t done;
+        } bulk;
     } v7m;
 
     /* Information associated with an exception about to be taken:
@@ -749,6 +779,14 @@ typedef struct CPUArchState {
         uint32_t *drsr;
         uint32_t *dracr;
         uint32_t rnr[M_REG_NUM_BANKS];
+        /*
+         * M-profile region lookup cache, built from the region registers
+         * by get_phys_addr_pmsav7() when first needed. Anything writing
+         * to drbar[], drsr[] or dracr[] must clear seg_valid.
+         */
+        ARMMPUSegment *seg;
+        uint32_t nr_seg;
+        bool seg_valid;
     } pmsav7;
 
     /* PMSAv8 MPU */
@@ -765,6 +803,14 @@ typedef struct CPUArchState {
         uint32_t mair0[M_REG_NUM_BANKS];
         uint32_t mair1[M_REG_NUM_BANKS];
         uint32_t hprselr;
+        /*
+         * M-profile region lookup cache, built from rbar[] and rlar[] by
+         * pmsav8_mpu_lookup() when first needed. Anything writing to
+         * rbar[] or rlar[] must clear seg_valid[] for that bank.
+         */
+        ARMMPUSegment *seg[M_REG_NUM_BANKS];
+        uint32_t nr_seg[M_REG_NUM_BANKS];
+        bool seg_valid[M_REG_NUM_BANKS];
     } pmsav8;
 
     /* v8M SAU */
@@ -950,6 +996,14 @@ struct ArchCPU {
     /* For v8M, initial value of the Non-secure VTOR */
     uint32_t init_nsvtor;
 
+    /*
+     * For M-profile, execute calls to the guest's memcpy and memset
+     * (found by armv7m_load_kernel()) with a host-side bulk helper.
+     */
+    bool bulk_mem;
+    uint32_t bulk_memcpy_addr;
+    uint32_t bulk_memset_addr;
+
     /* [QEMU_]KVM_ARM_TARGET_* constant for this CPU, or
      * QEMU_KVM_ARM_TARGET_NONE if the kernel doesn't support this CPU type.
      */
@@ -1181,6 +1235,7 @@ extern const VMStateDescription vmstate_arm_cpu;
 
 void arm_cpu_do_interrupt(CPUState *cpu);
 void arm_v7m_cpu_do_interrupt(CPUState *cpu);
+void arm_v7m_send_event(ARMCPU *cpu);
 
 hwaddr arm_cpu_get_phys_page_attrs_debug(CPUState *cpu, vaddr addr,
                                          MemTxAttrs *attrs);
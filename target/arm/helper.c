@@ -3918,6 +3918,7 @@ static void pmsav7_write(CPUARMState *env, const ARMCPRegInfo *ri,
     u32p += env->pmsav7.rnr[M_REG_NS];
     tlb_flush(CPU(cpu)); /* Mappings may have changed - purge! */
     *u32p = value;
+    env->pmsav7.seg_valid = false;
 }
 
 static void pmsav7_rgnr_write(CPUARMState *env, const ARMCPRegInfo *ri,
@@ -3943,6 +3944,7 @@ static void prbar_write(CPUARMState *env, const ARMCPRegInfo *ri,
 
     tlb_flush(CPU(cpu)); /* Mappings may have changed - purge! */
     env->pmsav8.rbar[M_REG_NS][env->pmsav7.rnr[M_REG_NS]] = value;
+    env->pmsav8.seg_valid[M_REG_NS] = false;
 }
 
 static uint64_t prbar_read(CPUARMState *env, const ARMCPRegInfo *ri)
@@ -3957,6 +3959,7 @@ static void prlar_write(CPUARMState *env, const ARMCPRegInfo *ri,
 
     tlb_flush(CPU(cpu)); /* Mappings may have changed - purge! */
     env->pmsav8.rlar[M_REG_NS][env->pmsav7.rnr[M_REG_NS]] = value;
+    env->pmsav8.seg_valid[M_REG_NS] = false;
 }
 
 static uint64_t prlar_read(CPUARMState *env, const ARMCPRegInfo *ri)
@@ -4087,6 +4090,7 @@ static void pmsav8r_regn_write(CPUARMState *env, const ARMCPRegInfo *ri,
         } else {
             env->pmsav8.rbar[M_REG_NS][index] = value;
         }
+        env->pmsav8.seg_valid[M_REG_NS] = false;
     }
 }
 
@@ -53,6 +53,7 @@ DEF_HELPER_2(exception_pc_alignment, noreturn, env, tl)
 DEF_HELPER_1(setend, void, env)
 DEF_HELPER_2(wfi, void, env, i32)
 DEF_HELPER_1(wfe, void, env)
+DEF_HELPER_1(sev, void, env)
 DEF_HELPER_2(wfit, void, env, i64)
 DEF_HELPER_1(yield, void, env)
 DEF_HELPER_1(pre_hvc, void, env)
@@ -68,6 +69,7 @@ DEF_HELPER_2(v7m_mrs, i32, env, i32)
 
 DEF_HELPER_2(v7m_bxns, void, env, i32)
 DEF_HELPER_2(v7m_blxns, void, env, i32)
+DEF_HELPER_1(v7m_exception_return, i32, env)
 
 DEF_HELPER_3(v7m_tt, i32, env, i32, i32)
 
@@ -76,6 +78,9 @@ DEF_HELPER_1(v7m_preserve_fp_state, void, env)
 DEF_HELPER_2(v7m_vlstm, void, env, i32)
 DEF_HELPER_2(v7m_vlldm, void, env, i32)
 
+DEF_HELPER_1(v7m_bulk_memcpy, void, env)
+DEF_HELPER_1(v7m_bulk_memset, void, env)
+
 DEF_HELPER_2(v8m_stackcheck, void, env, i32)
 
 DEF_HELPER_FLAGS_2(check_bxj_trap, TCG_CALL_NO_WG, void, env, i32)
@@ -475,6 +475,24 @@ static const VMStateDescription vmstate_m_v8m = {
     }
 };
 
+static bool m_event_needed(void *opaque)
+{
+    ARMCPU *cpu = opaque;
+
+    return cpu->env.v7m.event_register;
+}
+
+static const VMStateDescription vmstate_m_event = {
+    .name = "cpu/m/event",
+    .version_id = 1,
+    .minimum_version_id = 1,
+    .needed = m_event_needed,
+    .fields = (const VMStateField[]) {
+        VMSTATE_UINT32(env.v7m.event_register, ARMCPU),
+        VMSTATE_END_OF_LIST()
+    }
+};
+
 static const VMStateDescription vmstate_m_fp = {
     .name = "cpu/m/fp",
     .version_id = 1,
@@ -536,6 +554,7 @@ static const VMStateDescription vmstate_m = {
         &vmstate_m_v8m,
         &vmstate_m_fp,
         &vmstate_m_mve,
+        &vmstate_m_event,
         NULL
     }
 };
@@ -1024,6 +1043,10 @@ static int cpu_post_load(void *opaque, int version_id)
         pmu_op_finish(env);
     }
 
+    env->pmsav7.seg_valid = false;
+    env->pmsav8.seg_valid[M_REG_NS] = false;
+    env->pmsav8.seg_valid[M_REG_S] = false;
+
     if (tcg_enabled()) {
         arm_rebuild_hflags(env);
     }
@@ -2347,6 +2347,289 @@ static bool pmsav7_use_background_region(ARMCPU *cpu, ARMMMUIdx mmu_idx,
     return regime_sctlr(env, mmu_idx) & SCTLR_BR;
 }
 
+/*
+ * Look up @address in an M-profile MPU lookup cache of @nr_seg entries
+ * sorted by base, the first of which starts at 0, and return its region.
+ * If the segment holding @address does not cover the whole TARGET_PAGE,
+ * reduce @lg_page_size to the largest aligned block around @address that
+ * the segment does cover, so that the TLB can still cache the result.
+ */
+static int mpu_find_segment(ARMMPUSegment *seg, int nr_seg,
+                            uint32_t address, uint8_t *lg_page_size)
+{
+    uint32_t page_base = address & TARGET_PAGE_MASK;
+    uint32_t start, last;
+    int lo, hi;
+
+    /* Find the last segment starting at or below @address */
+    lo = 0;
+    hi = nr_seg - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+
+        if (seg[mid].base <= address) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    start = seg[lo].base;
+    last = lo + 1 < nr_seg ? seg[lo + 1].base - 1 : UINT32_MAX;
+    if (start > page_base || last < page_base + (TARGET_PAGE_SIZE - 1)) {
+        /* A one byte block always fits, so this stops by lg == 0 */
+        int lg = TARGET_PAGE_BITS - 1;
+        uint32_t mask;
+
+        for (;; lg--) {
+            mask = ~((1u << lg) - 1);
+            if ((address & mask) >= start && (address | ~mask) <= last) {
+                break;
+            }
+        }
+        *lg_page_size = MIN(*lg_page_size, lg);
+    }
+    return seg[lo].region;
+}
+
+static int mpu_bound_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * Return the log2 size of PMSAv7 region @n, or 0 if the region is
+ * disabled or its registers are invalid.
+ */
+static int pmsav7_region_size(CPUARMState *env, int n)
+{
+    uint32_t base = env->pmsav7.drbar[n];
+    uint32_t rsize = extract32(env->pmsav7.drsr[n], 1, 5);
+
+    if (!(env->pmsav7.drsr[n] & 0x1) || !rsize) {
+        return 0;
+    }
+    rsize++;
+    if (base & (uint32_t)((1ull << rsize) - 1)) {
+        return 0;
+    }
+    return rsize;
+}
+
+/* Does @address hit an enabled subregion of PMSAv7 region @n? */
+static bool pmsav7_region_hit(CPUARMState *env, int n, uint32_t address)
+{
+    int rsize = pmsav7_region_size(env, n);
+    uint32_t base = env->pmsav7.drbar[n];
+
+    if (!rsize || address - base > (uint32_t)((1ull << rsize) - 1)) {
+        return false;
+    }
+    /* no subregions for regions < 256 bytes */
+    return rsize < 8 ||
+        !extract32(env->pmsav7.drsr[n], 8 + ((address - base) >> (rsize - 3)),
+                   1);
+}
+
+/*
+ * Rebuild the PMSAv7 MPU lookup cache: split the address space at the
+ * base, the end and the subregion boundaries of every enabled region,
+ * and record for each piece the highest numbered region that has an
+ * enabled subregion there. The guest errors that the region scan in
+ * pmsav7_mpu_scan_regions() logs are logged here once per rebuild.
+ */
+static void pmsav7_mpu_build_segments(CPUARMState *env)
+{
+    ARMCPU *cpu = env_archcpu(env);
+    ARMMPUSegment *seg = env->pmsav7.seg;
+    g_autofree uint64_t *bounds = g_new(uint64_t, 9 * cpu->pmsav7_dregion + 1);
+    int nr_bounds = 0, nr_seg = 0;
+    int i, n;
+
+    bounds[nr_bounds++] = 0;
+    for (n = 0; n < cpu->pmsav7_dregion; n++) {
+        uint64_t base = env->pmsav7.drbar[n];
+        int rsize = pmsav7_region_size(env, n);
+
+        if (!rsize) {
+            if ((env->pmsav7.drsr[n] & 0x1) &&
+                !extract32(env->pmsav7.drsr[n], 1, 5)) {
+                qemu_log_mask(LOG_GUEST_ERROR,
+                              "DRSR[%d]: Rsize field cannot be 0\n", n);
+            } else if (env->pmsav7.drsr[n] & 0x1) {
+                qemu_log_mask(LOG_GUEST_ERROR,
+                              "DRBAR[%d]: 0x%" PRIx32 " misaligned "
+                              "to DRSR region size\n",
+                              n, env->pmsav7.drbar[n]);
+            }
+            continue;
+        }
+        bounds[nr_bounds++] = base;
+        bounds[nr_bounds++] = base + (1ull << rsize);
+        if (rsize >= 8) {
+            for (i = 1; i < 8; i++) {
+                bounds[nr_bounds++] = base + ((uint64_t)i << (rsize - 3));
+            }
+        }
+    }
+    qsort(bounds, nr_bounds, sizeof(*bounds), mpu_bound_cmp);
+
+    for (i = 0; i < nr_bounds; i++) {
+        uint32_t start = bounds[i];
+
+        if (bounds[i] > UINT32_MAX ||
+            (nr_seg && seg[nr_seg - 1].base == start)) {
+            continue;
+        }
+        /* The highest numbered region wins */
+        for (n = cpu->pmsav7_dregion - 1; n >= 0; n--) {
+            if (pmsav7_region_hit(env, n, start)) {
+                break;
+            }
+        }
+        seg[nr_seg].base = start;
+        seg[nr_seg].region = n;
+        nr_seg++;
+    }
+
+    env->pmsav7.nr_seg = nr_seg;
+    env->pmsav7.seg_valid = true;
+}
+
+/*
+ * Return the PMSAv7 MPU region that @address hits, or MPU_SEG_NO_REGION,
+ * using the lookup cache; see mpu_find_segment() for @lg_page_size.
+ */
+static int pmsav7_mpu_find_region(CPUARMState *env, uint32_t address,
+                                  uint8_t *lg_page_size)
+{
+    if (!env_archcpu(env)->pmsav7_dregion) {
+        return MPU_SEG_NO_REGION;
+    }
+    if (!env->pmsav7.seg_valid) {
+        pmsav7_mpu_build_segments(env);
+    }
+    return mpu_find_segment(env->pmsav7.seg, env->pmsav7.nr_seg,
+                            address, lg_page_size);
+}
+
+/*
+ * Scan the PMSAv7 MPU regions for @address, highest numbered first, and
+ * return the region that hits or -1. @lg_page_size is set as for
+ * mpu_find_segment(), except that a smaller than page result is only
+ * ever the region's own (sub)region size or 0.
+ */
+static int pmsav7_mpu_scan_regions(CPUARMState *env, uint32_t address,
+                                   uint8_t *lg_page_size)
+{
+    ARMCPU *cpu = env_archcpu(env);
+    /*
+     * Set once a higher priority region, or a disabled subregion,
+     * shares the page with the address: the region that hits may
+     * then only be used for this one access.
+     */
+    bool page_split = false;
+    int n;
+
+    for (n = (int)cpu->pmsav7_dregion - 1; n >= 0; n--) {
+        /* region search */
+        uint32_t base = env->pmsav7.drbar[n];
+        uint32_t rsize = extract32(env->pmsav7.drsr[n], 1, 5);
+        uint32_t rmask;
+        bool srdis = false;
+
+        if (!(env->pmsav7.drsr[n] & 0x1)) {
+            continue;
+        }
+
+        if (!rsize) {
+            qemu_log_mask(LOG_GUEST_ERROR,
+                          "DRSR[%d]: Rsize field cannot be 0\n", n);
+            continue;
+        }
+        rsize++;
+        rmask = (1ull << rsize) - 1;
+
+        if (base & rmask) {
+            qemu_log_mask(LOG_GUEST_ERROR,
+                          "DRBAR[%d]: 0x%" PRIx32 " misaligned "
+                          "to DRSR region size, mask = 0x%" PRIx32 "\n",
+                          n, base, rmask);
+            continue;
+        }
+
+        if (address < base || address > base + rmask) {
+            /*
+             * Address not in this region. We must check whether the
+             * region covers addresses in the same page as our address.
+             * In that case we must not report a size that covers the
+             * whole page for a subsequent hit against a different MPU
+             * region or the background region, because it would result in
+             * incorrect TLB hits for subsequent accesses to addresses that
+             * are in this MPU region.
+             */
+            if (ranges_overlap(base, rmask,
+                               address & TARGET_PAGE_MASK,
+                               TARGET_PAGE_SIZE)) {
+                *lg_page_size = 0;
+                page_split = true;
+            }
+            continue;
+        }
+
+        /* Region matched */
+
+        if (rsize >= 8) { /* no subregions for regions < 256 bytes */
+            int i, snd;
+            uint32_t srdis_mask;
+
+            rsize -= 3; /* sub region size (power of 2) */
+            snd = ((address - base) >> rsize) & 0x7;
+            srdis = extract32(env->pmsav7.drsr[n], snd + 8, 1);
+
+            srdis_mask = srdis ? 0x3 : 0x0;
+            for (i = 2; i <= 8 && rsize < TARGET_PAGE_BITS; i *= 2) {
+                /*
+                 * This will check in groups of 2, 4 and then 8, whether
+                 * the subregion bits are consistent. rsize is incremented
+                 * back up to give the region size, considering consistent
+                 * adjacent subregions as one region. Stop testing if rsize
+                 * is already big enough for an entire QEMU page.
+                 */
+                int snd_rounded = snd & ~(i - 1);
+                uint32_t srdis_multi = extract32(env->pmsav7.drsr[n],
+                                                 snd_rounded + 8, i);
+                if (srdis_mask ^ srdis_multi) {
+                    break;
+                }
+                srdis_mask = (srdis_mask << i) | srdis_mask;
+                rsize++;
+            }
+        }
+        if (srdis) {
+            /* The enabled rest of the region may share the page */
+            if (rsize < TARGET_PAGE_BITS) {
+                *lg_page_size = 0;
+                page_split = true;
+            }
+            continue;
+        }
+        /*
+         * A size smaller than a page tells the TLB that the whole
+         * aligned block has these permissions, which is only true
+         * if no higher priority region carves into it.
+         */
+        if (rsize < TARGET_PAGE_BITS && !page_split) {
+            *lg_page_size = rsize;
+        }
+        break;
+    }
+
+    return n;
+}
+
 static bool get_phys_addr_pmsav7(CPUARMState *env,
                                  S1Translate *ptw,
                                  uint32_t address,
@@ -2376,87 +2659,12 @@ static bool get_phys_addr_pmsav7(CPUARMState *env,
          */
         get_phys_addr_pmsav7_default(env, mmu_idx, address, &result->f.prot);
     } else { /* MPU enabled */
-        for (n = (int)cpu->pmsav7_dregion - 1; n >= 0; n--) {
-            /* region search */
-            uint32_t base = env->pmsav7.drbar[n];
-            uint32_t rsize = extract32(env->pmsav7.drsr[n], 1, 5);
-            uint32_t rmask;
-            bool srdis = false;
-
-            if (!(env->pmsav7.drsr[n] & 0x1)) {
-                continue;
-            }
-
-            if (!rsize) {
-                qemu_log_mask(LOG_GUEST_ERROR,
-                              "DRSR[%d]: Rsize field cannot be 0\n", n);
-                continue;
-            }
-            rsize++;
-            rmask = (1ull << rsize) - 1;
-
-            if (base & rmask) {
-                qemu_log_mask(LOG_GUEST_ERROR,
-                              "DRBAR[%d]: 0x%" PRIx32 " misaligned "
-                              "to DRSR region size, mask = 0x%" PRIx32 "\n",
-                              n, base, rmask);
-                continue;
-            }
-
-            if (address < base || address > base + rmask) {
-                /*
-                 * Address not in this region. We must check whether the
-                 * region covers addresses in the same page as our address.
-                 * In that case we must not report a size that covers the
-                 * whole page for a subsequent hit against a different MPU
-                 * region or the background region, because it would result in
-                 * incorrect TLB hits for subsequent accesses to addresses that
-                 * are in this MPU region.
-                 */
-                if (ranges_overlap(base, rmask,
-                                   address & TARGET_PAGE_MASK,
-                                   TARGET_PAGE_SIZE)) {
-                    result->f.lg_page_size = 0;
-                }
-                continue;
-            }
-
-            /* Region matched */
-
-            if (rsize >= 8) { /* no subregions for regions < 256 bytes */
-                int i, snd;
-                uint32_t srdis_mask;
-
-                rsize -= 3; /* sub region size (power of 2) */
-                snd = ((address - base) >> rsize) & 0x7;
-                srdis = extract32(env->pmsav7.drsr[n], snd + 8, 1);
-
-                srdis_mask = srdis ? 0x3 : 0x0;
-                for (i = 2; i <= 8 && rsize < TARGET_PAGE_BITS; i *= 2) {
-                    /*
-                     * This will check in groups of 2, 4 and then 8, whether
-                     * the subregion bits are consistent. rsize is incremented
-                     * back up to give the region size, considering consistent
-                     * adjacent subregions as one region. Stop testing if rsize
-                     * is already big enough for an entire QEMU page.
-                     */
-                    int snd_rounded = snd & ~(i - 1);
-                    uint32_t srdis_multi = extract32(env->pmsav7.drsr[n],
-                                                     snd_rounded + 8, i);
-                    if (srdis_mask ^ srdis_multi) {
-                        break;
-                    }
-                    srdis_mask = (srdis_mask << i) | srdis_mask;
-                    rsize++;
-                }
-            }
-            if (srdis) {
-                continue;
-            }
-            if (rsize < TARGET_PAGE_BITS) {
-                result->f.lg_page_size = rsize;
-            }
-            break;
+        if (arm_feature(env, ARM_FEATURE_M)) {
+            /* Cortex-M: use the cached region table */
+            n = pmsav7_mpu_find_region(env, address, &result->f.lg_page_size);
+        } else {
+            n = pmsav7_mpu_scan_regions(env, address,
+                                        &result->f.lg_page_size);
         }
 
         if (n == -1) { /* no hits */
@@ -2560,6 +2768,85 @@ static uint32_t *regime_rlar(CPUARMState *env, ARMMMUIdx mmu_idx,
     }
 }
 
+/*
+ * Rebuild the M-profile MPU lookup cache for one security bank: split the
+ * address space at the base and one past the limit of every enabled
+ * region, and record for each piece which region covers it. Nothing in
+ * a piece can then hit a different set of regions, and a TARGET_PAGE
+ * is covered uniformly by the regions exactly when no piece starts
+ * inside it.
+ */
+static void pmsav8_mpu_build_segments(CPUARMState *env, bool secure)
+{
+    ARMCPU *cpu = env_archcpu(env);
+    uint32_t *rbar = env->pmsav8.rbar[secure];
+    uint32_t *rlar = env->pmsav8.rlar[secure];
+    ARMMPUSegment *seg = env->pmsav8.seg[secure];
+    g_autofree uint64_t *bounds = g_new(uint64_t, 2 * cpu->pmsav7_dregion + 1);
+    int nr_bounds = 0, nr_seg = 0;
+    int i, n;
+
+    bounds[nr_bounds++] = 0;
+    for (n = 0; n < cpu->pmsav7_dregion; n++) {
+        uint32_t base = rbar[n] & ~0x1f;
+        uint32_t limit = rlar[n] | 0x1f;
+
+        if ((rlar[n] & 0x1) && limit >= base) {
+            bounds[nr_bounds++] = base;
+            bounds[nr_bounds++] = (uint64_t)limit + 1;
+        }
+    }
+    qsort(bounds, nr_bounds, sizeof(*bounds), mpu_bound_cmp);
+
+    for (i = 0; i < nr_bounds; i++) {
+        uint32_t start = bounds[i];
+        int region = MPU_SEG_NO_REGION;
+
+        if (bounds[i] > UINT32_MAX ||
+            (nr_seg && seg[nr_seg - 1].base == start)) {
+            continue;
+        }
+        for (n = cpu->pmsav7_dregion - 1; n >= 0; n--) {
+            uint32_t base = rbar[n] & ~0x1f;
+            uint32_t limit = rlar[n] | 0x1f;
+
+            if ((rlar[n] & 0x1) && start >= base && start <= limit) {
+                if (region != MPU_SEG_NO_REGION) {
+                    region = MPU_SEG_MULTIPLE_REGIONS;
+                    break;
+                }
+                region = n;
+            }
+        }
+        seg[nr_seg].base = start;
+        seg[nr_seg].region = region;
+        nr_seg++;
+    }
+
+    env->pmsav8.nr_seg[secure] = nr_seg;
+    env->pmsav8.seg_valid[secure] = true;
+}
+
+/*
+ * Return the M-profile MPU region that @address hits, or one of the
+ * MPU_SEG_* values, and reduce @lg_page_size if the regions do not
+ * cover the TARGET_PAGE containing @address uniformly. This gives the
+ * same answers as scanning every region, but costs O(log regions).
+ */
+static int pmsav8_mpu_find_region(CPUARMState *env, bool secure,
+                                  uint32_t address, uint8_t *lg_page_size)
+{
+    if (!env_archcpu(env)->pmsav7_dregion) {
+        return MPU_SEG_NO_REGION;
+    }
+    if (!env->pmsav8.seg_valid[secure]) {
+        pmsav8_mpu_build_segments(env, secure);
+    }
+    return mpu_find_segment(env->pmsav8.seg[secure],
+                            env->pmsav8.nr_seg[secure],
+                            address, lg_page_size);
+}
+
 bool pmsav8_mpu_lookup(CPUARMState *env, uint32_t address,
                        MMUAccessType access_type, ARMMMUIdx mmu_idx,
                        bool secure, GetPhysAddrResult *result,
@@ -2618,6 +2905,27 @@ bool pmsav8_mpu_lookup(CPUARMState *env, uint32_t address,
             hit = true;
         }
 
+        if (arm_feature(env, ARM_FEATURE_M)) {
+            /* Cortex-M: use the cached region table */
+            n = pmsav8_mpu_find_region(env, secure, address,
+                                       &result->f.lg_page_size);
+            if (n == MPU_SEG_MULTIPLE_REGIONS) {
+                /*
+                 * Multiple regions match -- always a failure (unlike
+                 * PMSAv7 where highest-numbered-region wins)
+                 */
+                fi->type = ARMFault_Permission;
+                fi->level = 1;
+                return true;
+            }
+            if (n != MPU_SEG_NO_REGION) {
+                matchregion = n;
+                hit = true;
+            }
+            /* Skip the region scan below */
+            region_counter = 0;
+        }
+
         uint32_t bitmask;
         if (arm_feature(env, ARM_FEATURE_M)) {
             bitmask = 0x1f;
@@ -115,6 +115,12 @@ void HELPER(v7m_blxns)(CPUARMState *env, uint32_t dest)
     g_assert_not_reached();
 }
 
+uint32_t HELPER(v7m_exception_return)(CPUARMState *env)
+{
+    /* translate.c should never generate calls here in user-only mode */
+    g_assert_not_reached();
+}
+
 void HELPER(v7m_preserve_fp_state)(CPUARMState *env)
 {
     /* translate.c should never generate calls here in user-only mode */
@@ -133,6 +139,18 @@ void HELPER(v7m_vlldm)(CPUARMState *env, uint32_t fptr)
     g_assert_not_reached();
 }
 
+void HELPER(v7m_bulk_memcpy)(CPUARMState *env)
+{
+    /* translate.c should never generate calls here in user-only mode */
+    g_assert_not_reached();
+}
+
+void HELPER(v7m_bulk_memset)(CPUARMState *env)
+{
+    /* translate.c should never generate calls here in user-only mode */
+    g_assert_not_reached();
+}
+
 uint32_t HELPER(v7m_tt)(CPUARMState *env, uint32_t addr, uint32_t op)
 {
     /*
@@ -356,6 +374,118 @@ pend_fault:
     return false;
 }
 
+/*
+ * MPU and SAU regions have a 32-byte granule, so one lookup per granule
+ * is enough to check a whole stack frame.  If the frame passes and is
+ * backed by RAM that is contiguous in the physical address space, it
+ * can be transferred with a single access, which cannot fault.
+ * Otherwise return false and let the caller use the per-word accessors,
+ * which also deal with reporting the fault; nothing has been accessed
+ * in that case.
+ */
+#define V7M_STACK_GRANULE 32
+#define V7M_STACK_MAX_WORDS 16
+
+static bool v7m_stack_lookup_fast(ARMCPU *cpu, uint32_t addr, uint32_t len,
+                                  ARMMMUIdx mmu_idx, MMUAccessType access_type,
+                                  hwaddr *phys, MemTxAttrs *attrs)
+{
+    CPUARMState *env = &cpu->env;
+    MemoryRegion *mr;
+    hwaddr xlat, plen = len;
+    uint32_t a;
+
+    if (addr + len < addr) {
+        return false;
+    }
+
+    for (a = addr; a - addr < len;
+         a = QEMU_ALIGN_DOWN(a, V7M_STACK_GRANULE) + V7M_STACK_GRANULE) {
+        GetPhysAddrResult res = {};
+        ARMMMUFaultInfo fi = {};
+
+        if (get_phys_addr(env, a, access_type, 0, mmu_idx, &res, &fi)) {
+            return false;
+        }
+        if (a == addr) {
+            *phys = res.f.phys_addr;
+            *attrs = res.f.attrs;
+        } else if (res.f.phys_addr != *phys + (a - addr) ||
+                   res.f.attrs.secure != attrs->secure ||
+                   res.f.attrs.space != attrs->space ||
+                   res.f.attrs.user != attrs->user) {
+            return false;
+        }
+    }
+
+    RCU_READ_LOCK_GUARD();
+    mr = address_space_translate(arm_addressspace(CPU(cpu), *attrs), *phys,
+                                 &xlat, &plen, access_type == MMU_DATA_STORE,
+                                 *attrs);
+    return plen >= len &&
+        memory_access_is_direct(mr, access_type == MMU_DATA_STORE, *attrs);
+}
+
+/* Push @n consecutive words, stopping at the first one that faults */
+static bool v7m_stack_write_words(ARMCPU *cpu, uint32_t addr,
+                                  const uint32_t *words, int n,
+                                  ARMMMUIdx mmu_idx, StackingMode mode)
+{
+    uint32_t buf[V7M_STACK_MAX_WORDS];
+    MemTxAttrs attrs;
+    hwaddr phys;
+    int i;
+
+    assert(n <= V7M_STACK_MAX_WORDS);
+    if (!v7m_stack_lookup_fast(cpu, addr, n * 4, mmu_idx, MMU_DATA_STORE,
+                               &phys, &attrs)) {
+        for (i = 0; i < n; i++) {
+            if (!v7m_stack_write(cpu, addr + i * 4, words[i], mmu_idx, mode)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    for (i = 0; i < n; i++) {
+        buf[i] = cpu_to_le32(words[i]);
+    }
+    address_space_write(arm_addressspace(CPU(cpu), attrs), phys, attrs,
+                        buf, n * 4);
+    return true;
+}
+
+/*
+ * Pop @n consecutive words; on a fault, the words before the faulting
+ * one have been stored to @dest and the rest are left untouched.
+ */
+static bool v7m_stack_read_words(ARMCPU *cpu, uint32_t *dest, uint32_t addr,
+                                 int n, ARMMMUIdx mmu_idx)
+{
+    uint32_t buf[V7M_STACK_MAX_WORDS];
+    MemTxAttrs attrs;
+    hwaddr phys;
+    int i;
+
+    assert(n <= V7M_STACK_MAX_WORDS);
+    if (!v7m_stack_lookup_fast(cpu, addr, n * 4, mmu_idx, MMU_DATA_LOAD,
+                               &phys, &attrs)) {
+        for (i = 0; i < n; i++) {
+            if (!v7m_stack_read(cpu, &dest[i], addr + i * 4, mmu_idx)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    address_space_read(arm_addressspace(CPU(cpu), attrs), phys, attrs,
+                       buf, n * 4);
+    for (i = 0; i < n; i++) {
+        dest[i] = le32_to_cpu(buf[i]);
+    }
+    return true;
+}
+
 void HELPER(v7m_preserve_fp_state)(CPUARMState *env)
 {
     /*
@@ -815,14 +945,8 @@ static bool v7m_push_callee_stack(ARMCPU *cpu, uint32_t lr, bool dotailchain,
     sig = v7m_integrity_sig(env, lr);
     stacked_ok =
         v7m_stack_write(cpu, frameptr, sig, mmu_idx, smode) &&
-        v7m_stack_write(cpu, frameptr + 0x8, env->regs[4], mmu_idx, smode) &&
-        v7m_stack_write(cpu, frameptr + 0xc, env->regs[5], mmu_idx, smode) &&
-        v7m_stack_write(cpu, frameptr + 0x10, env->regs[6], mmu_idx, smode) &&
-        v7m_stack_write(cpu, frameptr + 0x14, env->regs[7], mmu_idx, smode) &&
-        v7m_stack_write(cpu, frameptr + 0x18, env->regs[8], mmu_idx, smode) &&
-        v7m_stack_write(cpu, frameptr + 0x1c, env->regs[9], mmu_idx, smode) &&
-        v7m_stack_write(cpu, frameptr + 0x20, env->regs[10], mmu_idx, smode) &&
-        v7m_stack_write(cpu, frameptr + 0x24, env->regs[11], mmu_idx, smode);
+        v7m_stack_write_words(cpu, frameptr + 0x8, &env->regs[4], 8,
+                              mmu_idx, smode);
 
     /* Update SP regardless of whether any of the stack accesses failed. */
     *frame_sp_p = frameptr;
@@ -974,6 +1098,8 @@ static void v7m_exception_taken(ARMCPU *cpu, uint32_t lr, bool dotailchain,
     env->regs[14] = lr;
     env->regs[15] = addr & 0xfffffffe;
     env->thumb = addr & 1;
+    /* Exception entry is a WFE wakeup event */
+    env->v7m.event_register = 1;
     arm_rebuild_hflags(env);
 }
 
@@ -1187,6 +1313,7 @@ static bool v7m_push_stack(ARMCPU *cpu)
     uint32_t frameptr = env->regs[13];
     ARMMMUIdx mmu_idx = arm_mmu_idx(env);
     uint32_t framesize;
+    uint32_t frame[V7M_STACK_MAX_WORDS];
     bool nsacr_cp10 = extract32(env->v7m.nsacr, 10, 1);
 
     if ((env->v7m.control[M_REG_S] & R_V7M_CONTROL_FPCA_MASK) &&
@@ -1249,21 +1376,16 @@ static bool v7m_push_stack(ARMCPU *cpu)
      * (which may be taken in preference to the one we started with
      * if it has higher priority).
      */
+    frame[0] = env->regs[0];
+    frame[1] = env->regs[1];
+    frame[2] = env->regs[2];
+    frame[3] = env->regs[3];
+    frame[4] = env->regs[12];
+    frame[5] = env->regs[14];
+    frame[6] = env->regs[15];
+    frame[7] = xpsr;
     stacked_ok = stacked_ok &&
-        v7m_stack_write(cpu, frameptr, env->regs[0], mmu_idx, STACK_NORMAL) &&
-        v7m_stack_write(cpu, frameptr + 4, env->regs[1],
-                        mmu_idx, STACK_NORMAL) &&
-        v7m_stack_write(cpu, frameptr + 8, env->regs[2],
-                        mmu_idx, STACK_NORMAL) &&
-        v7m_stack_write(cpu, frameptr + 12, env->regs[3],
-                        mmu_idx, STACK_NORMAL) &&
-        v7m_stack_write(cpu, frameptr + 16, env->regs[12],
-                        mmu_idx, STACK_NORMAL) &&
-        v7m_stack_write(cpu, frameptr + 20, env->regs[14],
-                        mmu_idx, STACK_NORMAL) &&
-        v7m_stack_write(cpu, frameptr + 24, env->regs[15],
-                        mmu_idx, STACK_NORMAL) &&
-        v7m_stack_write(cpu, frameptr + 28, xpsr, mmu_idx, STACK_NORMAL);
+        v7m_stack_write_words(cpu, frameptr, frame, 8, mmu_idx, STACK_NORMAL);
 
     if (env->v7m.control[M_REG_S] & R_V7M_CONTROL_FPCA_MASK) {
         /* FPU is active, try to save its registers */
@@ -1303,20 +1425,22 @@ static bool v7m_push_stack(ARMCPU *cpu)
                     stacked_ok = false;
                 }
 
-                for (i = 0; i < ((framesize == 0xa8) ? 32 : 16); i += 2) {
-                    uint64_t dn = *aa32_vfp_dreg(env, i / 2);
+                for (i = 0; i < ((framesize == 0xa8) ? 32 : 16); i += 16) {
                     uint32_t faddr = frameptr + 0x20 + 4 * i;
-                    uint32_t slo = extract64(dn, 0, 32);
-                    uint32_t shi = extract64(dn, 32, 32);
+                    int j;
 
                     if (i >= 16) {
                         faddr += 8; /* skip the slot for the FPSCR and VPR */
                     }
+                    for (j = 0; j < 16; j += 2) {
+                        uint64_t dn = *aa32_vfp_dreg(env, (i + j) / 2);
+
+                        frame[j] = extract64(dn, 0, 32);
+                        frame[j + 1] = extract64(dn, 32, 32);
+                    }
                     stacked_ok = stacked_ok &&
-                        v7m_stack_write(cpu, faddr, slo,
-                                        mmu_idx, STACK_NORMAL) &&
-                        v7m_stack_write(cpu, faddr + 4, shi,
-                                        mmu_idx, STACK_NORMAL);
+                        v7m_stack_write_words(cpu, faddr, frame, 16,
+                                              mmu_idx, STACK_NORMAL);
                 }
                 stacked_ok = stacked_ok &&
                     v7m_stack_write(cpu, frameptr + 0x60,
@@ -1626,6 +1750,7 @@ static void do_v7m_exception_exit(ARMCPU *cpu)
         uint32_t *frame_sp_p = arm_v7m_get_sp_ptr(env, return_to_secure,
                                                   !return_to_handler, spsel);
         uint32_t frameptr = *frame_sp_p;
+        uint32_t frame[V7M_STACK_MAX_WORDS];
         bool pop_ok = true;
         ARMMMUIdx mmu_idx;
         bool return_to_priv = return_to_handler ||
@@ -1661,28 +1786,31 @@ static void do_v7m_exception_exit(ARMCPU *cpu)
             }
 
             pop_ok = pop_ok &&
-                v7m_stack_read(cpu, &env->regs[4], frameptr + 0x8, mmu_idx) &&
-                v7m_stack_read(cpu, &env->regs[5], frameptr + 0xc, mmu_idx) &&
-                v7m_stack_read(cpu, &env->regs[6], frameptr + 0x10, mmu_idx) &&
-                v7m_stack_read(cpu, &env->regs[7], frameptr + 0x14, mmu_idx) &&
-                v7m_stack_read(cpu, &env->regs[8], frameptr + 0x18, mmu_idx) &&
-                v7m_stack_read(cpu, &env->regs[9], frameptr + 0x1c, mmu_idx) &&
-                v7m_stack_read(cpu, &env->regs[10], frameptr + 0x20, mmu_idx) &&
-                v7m_stack_read(cpu, &env->regs[11], frameptr + 0x24, mmu_idx);
+                v7m_stack_read_words(cpu, &env->regs[4], frameptr + 0x8, 8,
+                                     mmu_idx);
 
             frameptr += 0x28;
         }
 
         /* Pop registers */
+        frame[0] = env->regs[0];
+        frame[1] = env->regs[1];
+        frame[2] = env->regs[2];
+        frame[3] = env->regs[3];
+        frame[4] = env->regs[12];
+        frame[5] = env->regs[14];
+        frame[6] = env->regs[15];
+        frame[7] = 0;
         pop_ok = pop_ok &&
-            v7m_stack_read(cpu, &env->regs[0], frameptr, mmu_idx) &&
-            v7m_stack_read(cpu, &env->regs[1], frameptr + 0x4, mmu_idx) &&
-            v7m_stack_read(cpu, &env->regs[2], frameptr + 0x8, mmu_idx) &&
-            v7m_stack_read(cpu, &env->regs[3], frameptr + 0xc, mmu_idx) &&
-            v7m_stack_read(cpu, &env->regs[12], frameptr + 0x10, mmu_idx) &&
-            v7m_stack_read(cpu, &env->regs[14], frameptr + 0x14, mmu_idx) &&
-            v7m_stack_read(cpu, &env->regs[15], frameptr + 0x18, mmu_idx) &&
-            v7m_stack_read(cpu, &xpsr, frameptr + 0x1c, mmu_idx);
+            v7m_stack_read_words(cpu, frame, frameptr, 8, mmu_idx);
+        env->regs[0] = frame[0];
+        env->regs[1] = frame[1];
+        env->regs[2] = frame[2];
+        env->regs[3] = frame[3];
+        env->regs[12] = frame[4];
+        env->regs[14] = frame[5];
+        env->regs[15] = frame[6];
+        xpsr = frame[7];
 
         if (!pop_ok) {
             /*
@@ -1788,25 +1916,25 @@ static void do_v7m_exception_exit(ARMCPU *cpu)
                     return;
                 }
 
-                for (i = 0; i < (restore_s16_s31 ? 32 : 16); i += 2) {
-                    uint32_t slo, shi;
-                    uint64_t dn;
+                for (i = 0; i < (restore_s16_s31 ? 32 : 16); i += 16) {
                     uint32_t faddr = frameptr + 0x20 + 4 * i;
+                    int j;
 
                     if (i >= 16) {
                         faddr += 8; /* Skip the slot for the FPSCR and VPR */
                     }
 
                     pop_ok = pop_ok &&
-                        v7m_stack_read(cpu, &slo, faddr, mmu_idx) &&
-                        v7m_stack_read(cpu, &shi, faddr + 4, mmu_idx);
+                        v7m_stack_read_words(cpu, frame, faddr, 16, mmu_idx);
 
                     if (!pop_ok) {
                         break;
                     }
 
-                    dn = (uint64_t)shi << 32 | slo;
-                    *aa32_vfp_dreg(env, i / 2) = dn;
+                    for (j = 0; j < 16; j += 2) {
+                        *aa32_vfp_dreg(env, (i + j) / 2) =
+                            (uint64_t)frame[j + 1] << 32 | frame[j];
+                    }
                 }
                 pop_ok = pop_ok &&
                     v7m_stack_read(cpu, &fpscr, frameptr + 0x60, mmu_idx);
@@ -1896,10 +2024,41 @@ static void do_v7m_exception_exit(ARMCPU *cpu)
 
     /* Otherwise, we have a successful exception exit. */
     arm_clear_exclusive(env);
+    env->v7m.event_register = 1;
     arm_rebuild_hflags(env);
     qemu_log_mask(CPU_LOG_INT, "...successful exception return\n");
 }
 
+uint32_t HELPER(v7m_exception_return)(CPUARMState *env)
+{
+    /*
+     * Called from the end of a TB that branched to a magic address in
+     * the exception-return range, with the magic value still split
+     * between env->regs[15] and env->thumb. Perform the exception return
+     * here and return 1 if translated code can just continue at the
+     * new PC (the hflags have been rebuilt, so the next TB is looked up
+     * correctly). Return 0 without doing anything for the cases left
+     * to the EXCP_EXCEPTION_EXIT path in the main loop: FNC_RETURN, and
+     * exception returns that switch security state.
+     */
+    ARMCPU *cpu = env_archcpu(env);
+    uint32_t excret = env->regs[15];
+
+    if (excret < EXC_RETURN_MIN_MAGIC) {
+        return 0;
+    }
+    if (arm_feature(env, ARM_FEATURE_M_SECURITY) &&
+        FIELD_EX32(excret, V7M_EXCRET, S) != env->v7m.secure) {
+        return 0;
+    }
+
+    /* Take the BQL as we are going to touch the NVIC */
+    bql_lock();
+    do_v7m_exception_exit(cpu);
+    bql_unlock();
+    return 1;
+}
+
 static bool do_v7m_function_return(ARMCPU *cpu)
 {
     /*
@@ -2864,6 +3023,159 @@ uint32_t HELPER(v7m_tt)(CPUARMState *env, uint32_t addr, uint32_t op)
     return tt_resp;
 }
 
+/*
+ * Probe up to @len bytes at @addr for the bulk memory helpers, stopping
+ * at the end of the page or of a smaller MPU region. Return the number
+ * of bytes covered, and set *@host if they can be accessed directly as
+ * host memory (otherwise the caller must use byte accesses, for MMIO
+ * and watchpoints). Faults are raised as for the first byte accessed.
+ */
+static uint32_t v7m_bulk_probe(CPUARMState *env, uint32_t addr, uint32_t len,
+                               MMUAccessType access_type, int mmu_idx,
+                               void **host, uintptr_t ra)
+{
+    CPUTLBEntryFull *full;
+    uint32_t n = MIN(len, TARGET_PAGE_SIZE - (addr & ~TARGET_PAGE_MASK));
+    int flags;
+
+    flags = probe_access_full(env, addr, 0, access_type, mmu_idx,
+                              false, host, &full, ra);
+    if (full->lg_page_size < TARGET_PAGE_BITS) {
+        uint32_t block = 1U << full->lg_page_size;
+
+        n = MIN(n, block - (addr & (block - 1)));
+    }
+    if (access_type == MMU_DATA_STORE && *host) {
+        /* Mark the whole range dirty, not just its first byte */
+        flags = probe_access_full(env, addr, n, access_type, mmu_idx,
+                                  false, host, &full, ra);
+    }
+    if (flags & TLB_WATCHPOINT) {
+        *host = NULL;
+    }
+    return n;
+}
+
+/*
+ * Start the bulk memory call at @pc. If the previous call was left by
+ * v7m_bulk_progress() to take an interrupt and this is the same call
+ * resumed, with the same arguments, stack pointer and return address,
+ * return the number of bytes it had done; otherwise start from 0. The
+ * record is used up either way, so that it cannot be picked up by some
+ * later call. After a fault the call restarts from the beginning.
+ */
+static uint32_t v7m_bulk_begin(CPUARMState *env, uint32_t pc)
+{
+    bool resume = env->v7m.bulk.valid && env->v7m.bulk.pc == pc &&
+        env->v7m.bulk.sp == env->regs[13] &&
+        env->v7m.bulk.lr == env->regs[14] &&
+        !memcmp(env->v7m.bulk.args, env->regs, sizeof(env->v7m.bulk.args));
+
+    env->v7m.bulk.valid = false;
+    return resume ? env->v7m.bulk.done : 0;
+}
+
+/*
+ * @done bytes of the bulk memory call at @pc have been done. If more
+ * remain and an interrupt is pending, record the progress and leave the
+ * helper so that it can be taken: the argument registers have not been
+ * changed, so the call resumes from here when the interrupt returns to
+ * the function entry. This bounds the interrupt latency of a long call
+ * to a page.
+ */
+static void v7m_bulk_progress(CPUARMState *env, uint32_t pc, uint32_t done,
+                              uint32_t len, uintptr_t ra)
+{
+    CPUState *cs = env_cpu(env);
+
+    if (done < len && unlikely(cpu_loop_exit_requested(cs))) {
+        env->v7m.bulk.valid = true;
+        env->v7m.bulk.pc = pc;
+        env->v7m.bulk.sp = env->regs[13];
+        env->v7m.bulk.lr = env->regs[14];
+        memcpy(env->v7m.bulk.args, env->regs, sizeof(env->v7m.bulk.args));
+        env->v7m.bulk.done = done;
+        cpu_loop_exit_restore(cs, ra);
+    }
+}
+
+void HELPER(v7m_bulk_memcpy)(CPUARMState *env)
+{
+    int mmu_idx = arm_to_core_mmu_idx(arm_mmu_idx(env));
+    uint32_t pc = env_archcpu(env)->bulk_memcpy_addr;
+    uint32_t len = env->regs[2];
+    uintptr_t ra = GETPC();
+    uint32_t done = v7m_bulk_begin(env, pc);
+
+    /*
+     * Copy in increasing address order, as the guest code would. If an
+     * access faults, the exception is taken at the function entry with
+     * the arguments unchanged, and the copy starts again once the fault
+     * has been handled.
+     */
+    while (done < len) {
+        uint32_t dest = env->regs[0] + done;
+        uint32_t src = env->regs[1] + done;
+        uint8_t *shost, *dhost;
+        uint32_t n, i;
+
+        n = v7m_bulk_probe(env, src, len - done, MMU_DATA_LOAD, mmu_idx,
+                           (void **)&shost, ra);
+        n = v7m_bulk_probe(env, dest, n, MMU_DATA_STORE, mmu_idx,
+                           (void **)&dhost, ra);
+        if (shost && dhost) {
+            if (dhost > shost && dhost < shost + n) {
+                /*
+                 * A forward copy onto an overlapping higher destination
+                 * reads back bytes it has already written, which
+                 * memmove() would not do.
+                 */
+                for (i = 0; i < n; i++) {
+                    dhost[i] = shost[i];
+                }
+            } else {
+                memmove(dhost, shost, n);
+            }
+        } else {
+            for (i = 0; i < n; i++) {
+                uint8_t b = cpu_ldub_mmuidx_ra(env, src + i, mmu_idx, ra);
+
+                cpu_stb_mmuidx_ra(env, dest + i, b, mmu_idx, ra);
+            }
+        }
+        done += n;
+        v7m_bulk_progress(env, pc, done, len, ra);
+    }
+}
+
+void HELPER(v7m_bulk_memset)(CPUARMState *env)
+{
+    int mmu_idx = arm_to_core_mmu_idx(arm_mmu_idx(env));
+    uint32_t pc = env_archcpu(env)->bulk_memset_addr;
+    uint8_t c = env->regs[1];
+    uint32_t len = env->regs[2];
+    uintptr_t ra = GETPC();
+    uint32_t done = v7m_bulk_begin(env, pc);
+
+    while (done < len) {
+        uint32_t dest = env->regs[0] + done;
+        void *dhost;
+        uint32_t n, i;
+
+        n = v7m_bulk_probe(env, dest, len - done, MMU_DATA_STORE, mmu_idx,
+                           &dhost, ra);
+        if (dhost) {
+            memset(dhost, c, n);
+        } else {
+            for (i = 0; i < n; i++) {
+                cpu_stb_mmuidx_ra(env, dest + i, c, mmu_idx, ra);
+            }
+        }
+        done += n;
+        v7m_bulk_progress(env, pc, done, len, ra);
+    }
+}
+
 #endif /* !CONFIG_USER_ONLY */
 
 uint32_t *arm_v7m_get_sp_ptr(CPUARMState *env, bool secure, bool threadmode,
@@ -471,8 +471,31 @@ void HELPER(wfit)(CPUARMState *env, uint64_t timeout)
 
 void HELPER(wfe)(CPUARMState *env)
 {
+#ifndef CONFIG_USER_ONLY
+    if (arm_feature(env, ARM_FEATURE_M)) {
+        CPUState *cs = env_cpu(env);
+
+        /*
+         * M-profile: consume a pending event, or sleep until one of
+         * SEV, SEVONPEND or an interrupt that we would take arrives.
+         * Exception entry and return set the event register too, so a
+         * "while (!flag) { __WFE(); }" loop waiting for an interrupt
+         * handler does not spin.
+         */
+        if (qatomic_xchg(&env->v7m.event_register, 0)) {
+            return;
+        }
+        if (cpu_has_work(cs)) {
+            return;
+        }
+        cs->exception_index = EXCP_HLT;
+        cs->halted = 1;
+        cpu_loop_exit(cs);
+    }
+#endif
     /* This is a hint instruction that is semantically different
-     * from YIELD even though we currently implement it identically.
+     * from YIELD even though we currently implement it identically
+     * for A and R profile.
      * Don't actually halt the CPU, just yield back to top
      * level loop. This is not going into a "low power state"
      * (ie halting until some event occurs), so we never take
@@ -481,6 +504,21 @@ void HELPER(wfe)(CPUARMState *env)
     HELPER(yield)(env);
 }
 
+void HELPER(sev)(CPUARMState *env)
+{
+#ifndef CONFIG_USER_ONLY
+    CPUState *cs;
+
+    /* SEV sets the event register of every processor, including ours */
+    env->v7m.event_register = 1;
+    CPU_FOREACH(cs) {
+        if (cs != env_cpu(env) && arm_feature(cpu_env(cs), ARM_FEATURE_M)) {
+            arm_v7m_send_event(ARM_CPU(cs));
+        }
+    }
+#endif
+}
+
 void HELPER(yield)(CPUARMState *env)
 {
     CPUState *cs = env_cpu(env);
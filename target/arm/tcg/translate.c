@@ -816,20 +816,38 @@ static inline void gen_bx_excret_final_code(DisasContext *s)
 
     /* Is the new PC value in the magic range indicating exception return? */
     tcg_gen_brcondi_i32(TCG_COND_GEU, cpu_R[15], min_magic, excret_label.label);
-    /* No: end the TB as we would for a DISAS_JMP */
+    /* No: end the TB as we would for a DISAS_JUMP */
     if (s->ss_active) {
         gen_singlestep_exception(s);
     } else {
-        tcg_gen_exit_tb(NULL, 0);
+        tcg_gen_lookup_and_goto_ptr();
     }
     set_disas_label(s, excret_label);
     /* Yes: this is an exception return.
      * At this point in runtime env->regs[15] and env->thumb will hold
      * the exception-return magic number, which do_v7m_exception_exit()
      * will read. Nothing else will be able to see those values because
-     * the cpu-exec main loop guarantees that we will always go straight
+     * either the helper below consumes them straight away, or the
+     * cpu-exec main loop guarantees that we will always go straight
      * from raising the exception to the exception-handling code.
-     *
+     */
+    if (!s->ss_active) {
+        /*
+         * Most exception returns stay in the same security state, so
+         * let the helper do those inline and carry on with whatever TB
+         * comes next, without a trip through the main loop. If another
+         * exception is now ready to be taken the NVIC will already have
+         * requested an exit at the start of that TB.
+         */
+        TCGv_i32 done = tcg_temp_new_i32();
+        DisasLabel slow_label = gen_disas_label(s);
+
+        gen_helper_v7m_exception_return(done, tcg_env);
+        tcg_gen_brcondi_i32(TCG_COND_EQ, done, 0, slow_label.label);
+        tcg_gen_lookup_and_goto_ptr();
+        set_disas_label(s, slow_label);
+    }
+    /*
      * gen_ss_advance(s) does nothing on M profile currently but
      * calling it is conceptually the right thing as we have executed
      * this instruction (compare SWI, HVC, SMC handling).
@@ -4498,19 +4516,30 @@ static bool trans_YIELD(DisasContext *s, arg_YIELD *a)
 static bool trans_WFE(DisasContext *s, arg_WFE *a)
 {
     /*
-     * When running single-threaded TCG code, use the helper to ensure that
-     * the next round-robin scheduled vCPU gets a crack.  In MTTCG mode we
-     * just skip this instruction.  Currently the SEV/SEVL instructions,
-     * which are *one* of many ways to wake the CPU from WFE, are not
-     * implemented so we can't sleep like WFI does.
+     * M-profile implements the event register, so the helper can sleep
+     * like WFI does until an event arrives.  Otherwise, when running
+     * single-threaded TCG code, use the helper to ensure that the next
+     * round-robin scheduled vCPU gets a crack; in MTTCG mode we just skip
+     * this instruction, since SEV/SEVL, which are *one* of many ways to
+     * wake the CPU from WFE, are not implemented for A and R profile.
      */
-    if (!(tb_cflags(s->base.tb) & CF_PARALLEL)) {
+    if (arm_dc_feature(s, ARM_FEATURE_M) ||
+        !(tb_cflags(s->base.tb) & CF_PARALLEL)) {
         gen_update_pc(s, curr_insn_len(s));
         s->base.is_jmp = DISAS_WFE;
     }
     return true;
 }
 
+static bool trans_SEV(DisasContext *s, arg_SEV *a)
+{
+    /* Only M-profile has an event register, elsewhere SEV is a NOP */
+    if (arm_dc_feature(s, ARM_FEATURE_M)) {
+        gen_helper_sev(tcg_env);
+    }
+    return true;
+}
+
 static bool trans_WFI(DisasContext *s, arg_WFI *a)
 {
     /* For WFI, halt the vCPU until an IRQ. */
@@ -7612,6 +7641,10 @@ static void arm_tr_init_disas_context(DisasContextBase *dcbase, CPUState *cs)
             EX_TBFLAG_M32(tb_flags, NEW_FP_CTXT_NEEDED);
         dc->v7m_lspact = EX_TBFLAG_M32(tb_flags, LSPACT);
         dc->mve_no_pred = EX_TBFLAG_M32(tb_flags, MVE_NO_PRED);
+        if (cpu->bulk_mem) {
+            dc->v7m_bulk_memcpy = cpu->bulk_memcpy_addr;
+            dc->v7m_bulk_memset = cpu->bulk_memset_addr;
+        }
     } else {
         dc->sctlr_b = EX_TBFLAG_A32(tb_flags, SCTLR__B);
         dc->hstr_active = EX_TBFLAG_A32(tb_flags, HSTR_ACTIVE);
@@ -7870,6 +7903,28 @@ static bool thumb_insn_is_unconditional(DisasContext *s, uint32_t insn)
     return false;
 }
 
+/*
+ * With the x-bulk-mem CPU property, the first insn of the guest's memcpy
+ * or memset is replaced by a helper doing the whole call, followed by the
+ * function's return (BX LR). Only the AAPCS call-clobbered registers
+ * differ from running the guest code, and R0 is the return value.
+ */
+static bool disas_v7m_bulk_mem(DisasContext *s)
+{
+    if (s->condexec_mask || s->eci) {
+        return false;
+    }
+    if (s->v7m_bulk_memcpy && s->pc_curr == s->v7m_bulk_memcpy) {
+        gen_helper_v7m_bulk_memcpy(tcg_env);
+    } else if (s->v7m_bulk_memset && s->pc_curr == s->v7m_bulk_memset) {
+        gen_helper_v7m_bulk_memset(tcg_env);
+    } else {
+        return false;
+    }
+    gen_bx_excret(s, load_reg(s, 14));
+    return true;
+}
+
 static void thumb_tr_translate_insn(DisasContextBase *dcbase, CPUState *cpu)
 {
     DisasContext *dc = container_of(dcbase, DisasContext, base);
@@ -7957,7 +8012,9 @@ static void thumb_tr_translate_insn(DisasContextBase *dcbase, CPUState *cpu)
         }
     }
 
-    if (is_16bit) {
+    if (disas_v7m_bulk_mem(dc)) {
+        /* the whole function has been handled */
+    } else if (is_16bit) {
         disas_thumb_insn(dc, insn);
     } else {
         disas_thumb2_insn(dc, insn);
@@ -8090,6 +8147,8 @@ static void arm_tr_tb_stop(DisasContextBase *dcbase, CPUState *cpu)
             break;
         case DISAS_WFE:
             gen_helper_wfe(tcg_env);
+            /* On M-profile the helper returns if an event was pending. */
+            tcg_gen_exit_tb(NULL, 0);
             break;
         case DISAS_YIELD:
             gen_helper_yield(tcg_env);
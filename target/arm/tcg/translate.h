@@ -82,6 +82,9 @@ typedef struct DisasContext {
     bool v8m_fpccr_s_wrong; /* true if v8M FPCCR.S != v8m_secure */
     bool v7m_new_fp_ctxt_needed; /* ASPEN set but no active FP context */
     bool v7m_lspact; /* FPCCR.LSPACT set */
+    /* Entry points to run with the bulk memory helpers, or 0 */
+    uint32_t v7m_bulk_memcpy;
+    uint32_t v7m_bulk_memset;
     /* Immediate value in AArch32 SVC insn; must be set if is_jmp == DISAS_SWI
      * so that top level loop can generate correct syndrome information.
      */
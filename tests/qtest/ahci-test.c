@@ -32,6 +32,7 @@
 
 #include "qobject/qdict.h"
 #include "qemu/host-utils.h"
+#include "qemu/units.h"
 
 #include "hw/pci/pci_ids.h"
 #include "hw/pci/pci_regs.h"
@@ -1066,6 +1067,97 @@ static void test_dma_fragmented(void)
     g_free(tx);
 }
 
+/*
+ * Benchmark for the HBA's scatter/gather copies: the data of PIO commands
+ * moves between the drive and the guest through dma_buf_read() and
+ * dma_buf_write(), one 512 byte DRQ block at a time, spread over as many
+ * PRDs as the block covers.  Issue the same command repeatedly with ever
+ * smaller PRDs, so that the per-entry cost of the copies shows up.
+ */
+#define BENCH_BUFSIZE (16 * 1024)
+#define BENCH_ITERATIONS 200
+
+typedef struct AHCIBenchCase {
+    const char *name;
+    uint8_t cmd;
+    unsigned prd_size;
+} AHCIBenchCase;
+
+static const AHCIBenchCase bench_cases[] = {
+    { "read/prd-4096", CMD_READ_PIO, 4096 },
+    { "read/prd-512", CMD_READ_PIO, 512 },
+    { "read/prd-64", CMD_READ_PIO, 64 },
+    { "read/prd-8", CMD_READ_PIO, 8 },
+    { "write/prd-4096", CMD_WRITE_PIO, 4096 },
+    { "write/prd-512", CMD_WRITE_PIO, 512 },
+    { "write/prd-64", CMD_WRITE_PIO, 64 },
+    { "write/prd-8", CMD_WRITE_PIO, 8 },
+};
+
+static void test_bench_pio(const void *data)
+{
+    const AHCIBenchCase *c = data;
+    AHCIQState *ahci;
+    AHCICommand *cmd;
+    uint8_t px;
+    unsigned char *tx = g_malloc(BENCH_BUFSIZE);
+    unsigned char *rx = g_malloc0(BENCH_BUFSIZE);
+    uint64_t ptr;
+    double elapsed;
+    int i;
+
+    ahci = ahci_boot_and_enable(NULL);
+    px = ahci_port_select(ahci);
+    ahci_port_clear(ahci, px);
+
+    /* Put the pattern on the disk and in the guest buffer. */
+    generate_pattern(tx, BENCH_BUFSIZE, AHCI_SECTOR_SIZE);
+    ptr = ahci_alloc(ahci, BENCH_BUFSIZE);
+    g_assert(ptr);
+    qtest_bufwrite(ahci->parent->qts, ptr, tx, BENCH_BUFSIZE);
+    ahci_guest_io(ahci, px, CMD_WRITE_DMA, ptr, BENCH_BUFSIZE, 0);
+    if (c->cmd == CMD_READ_PIO) {
+        qtest_memset(ahci->parent->qts, ptr, 0x00, BENCH_BUFSIZE);
+    }
+
+    /*
+     * Set the command up once; the HBA reads the command table afresh
+     * each time it is issued.  Only the last completion is checked, so
+     * that the loop is not dominated by register reads.
+     */
+    cmd = ahci_command_create(c->cmd);
+    ahci_command_adjust(cmd, 0, ptr, BENCH_BUFSIZE, c->prd_size);
+    ahci_command_commit(ahci, cmd, px);
+
+    g_test_timer_start();
+    for (i = 0; i < BENCH_ITERATIONS; i++) {
+        ahci_command_issue(ahci, cmd);
+    }
+    elapsed = g_test_timer_elapsed();
+
+    ahci_command_verify(ahci, cmd);
+    ahci_command_free(cmd);
+
+    g_test_message("%s: %d x %d bytes in %d byte PRDs in %.3f s "
+                   "(%.1f MiB/s)", c->name, BENCH_ITERATIONS, BENCH_BUFSIZE,
+                   c->prd_size, elapsed,
+                   BENCH_ITERATIONS * (double)BENCH_BUFSIZE / MiB / elapsed);
+
+    /* Check that the data made it through. */
+    if (c->cmd == CMD_WRITE_PIO) {
+        qtest_memset(ahci->parent->qts, ptr, 0x00, BENCH_BUFSIZE);
+        ahci_guest_io(ahci, px, CMD_READ_DMA, ptr, BENCH_BUFSIZE, 0);
+    }
+    qtest_bufread(ahci->parent->qts, ptr, rx, BENCH_BUFSIZE);
+    g_assert_cmphex(memcmp(tx, rx, BENCH_BUFSIZE), ==, 0);
+
+    ahci_free(ahci, ptr);
+    ahci_shutdown(ahci);
+
+    g_free(rx);
+    g_free(tx);
+}
+
 /*
  * Write sector 1 with random data to make AHCI storage dirty
  * Needed for flush tests so that flushes actually go though the block layer
@@ -2043,6 +2135,15 @@ int main(int argc, char **argv)
     qtest_add_func("/ahci/cdrom/pio/bcl", test_atapi_bcl);
     qtest_add_func("/ahci/cdrom/eject", test_atapi_tray);
 
+    if (g_test_perf()) {
+        for (i = 0; i < ARRAY_SIZE(bench_cases); i++) {
+            g_autofree char *path = g_strdup_printf("/ahci/bench/pio/%s",
+                                                    bench_cases[i].name);
+
+            qtest_add_data_func(path, &bench_cases[i], test_bench_pio);
+        }
+    }
+
     ret = g_test_run();
 
     /* Cleanup */
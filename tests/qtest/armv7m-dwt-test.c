@@ -0,0 +1,78 @@
+/*
+ * QTest testcase for the ARMv7M DWT cycle counter
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "qemu/osdep.h"
+#include "libqtest-single.h"
+
+/* The CPU in mps2-an385 runs at 25MHz, so 40ns per cycle */
+#define DWT_BASE 0xe0001000
+
+#define CTRL 0
+#define CYCCNT 4
+#define PIDR0 0xfe0
+
+#define CTRL_CYCCNTENA (1 << 0)
+#define CTRL_NOCYCCNT (1 << 25)
+
+static void test_cyccnt(void)
+{
+    uint32_t ctrl = readl(DWT_BASE + CTRL);
+
+    /* The cycle counter is implemented and starts off disabled */
+    g_assert_cmpuint(ctrl & CTRL_NOCYCCNT, ==, 0);
+    g_assert_cmpuint(ctrl & CTRL_CYCCNTENA, ==, 0);
+    g_assert_cmpuint(readl(DWT_BASE + CYCCNT), ==, 0);
+    g_assert_cmpuint(readl(DWT_BASE + PIDR0), ==, 0x02);
+
+    /* Disabled: time passing does not count */
+    clock_step(40 * 100);
+    g_assert_cmpuint(readl(DWT_BASE + CYCCNT), ==, 0);
+
+    writel(DWT_BASE + CTRL, CTRL_CYCCNTENA);
+    clock_step(40 * 1000);
+    g_assert_cmpuint(readl(DWT_BASE + CYCCNT), ==, 1000);
+
+    /* Writes set the count, which then carries on from there */
+    writel(DWT_BASE + CYCCNT, 0xfffffff0);
+    clock_step(40 * 0x20);
+    g_assert_cmpuint(readl(DWT_BASE + CYCCNT), ==, 0x10);
+
+    /* Disabling freezes the count */
+    writel(DWT_BASE + CTRL, 0);
+    clock_step(40 * 1000);
+    g_assert_cmpuint(readl(DWT_BASE + CYCCNT), ==, 0x10);
+    writel(DWT_BASE + CTRL, CTRL_CYCCNTENA);
+    clock_step(40 * 5);
+    g_assert_cmpuint(readl(DWT_BASE + CYCCNT), ==, 0x15);
+
+    writel(DWT_BASE + CTRL, 0);
+    writel(DWT_BASE + CYCCNT, 0);
+}
+
+int main(int argc, char **argv)
+{
+    int r;
+
+    g_test_init(&argc, &argv, NULL);
+
+    qtest_start("-machine mps2-an385");
+
+    qtest_add_func("/armv7m-dwt/cyccnt", test_cyccnt);
+
+    r = g_test_run();
+
+    qtest_end();
+
+    return r;
+}
@@ -0,0 +1,180 @@
+/*
+ * QTest testcase for the ARMv7M NVIC pending exception selection
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "qemu/osdep.h"
+#include "libqtest-single.h"
+
+/* mps2-an511 is a Cortex-M3 with 64 external interrupts */
+#define NUM_IRQ 64
+
+#define NVIC_BASE 0xe000e000
+#define ISER (NVIC_BASE + 0x100)
+#define ICER (NVIC_BASE + 0x180)
+#define ISPR (NVIC_BASE + 0x200)
+#define ICPR (NVIC_BASE + 0x280)
+#define IPR (NVIC_BASE + 0x400)
+#define ICSR (NVIC_BASE + 0xd04)
+
+#define ICSR_VECTPENDING_SHIFT 12
+#define ICSR_VECTPENDING_MASK 0x1ff
+#define ICSR_ISRPENDING (1 << 22)
+
+#define BENCH_ITERATIONS 100000
+
+/*
+ * Machines to run the benchmark on, to see how the pending exception
+ * selection scales with the number of external interrupts. The
+ * TrustZone boards are left out: qtest accesses are Non-secure, and
+ * all interrupts are Secure out of reset, so they cannot be driven.
+ */
+typedef struct NVICBenchMachine {
+    const char *machine;
+    int num_irq;
+} NVICBenchMachine;
+
+static const NVICBenchMachine bench_machines[] = {
+    { "mps2-an385", 32 },
+    { "mps2-an511", 64 },
+    { "ast1030-evb", 256 },
+};
+
+static void irq_write(uint32_t base, int irq)
+{
+    writel(base + (irq / 32) * 4, 1U << (irq % 32));
+}
+
+static void irq_set_prio(int irq, uint8_t prio)
+{
+    writeb(IPR + irq, prio);
+}
+
+static unsigned vectpending(void)
+{
+    return (readl(ICSR) >> ICSR_VECTPENDING_SHIFT) & ICSR_VECTPENDING_MASK;
+}
+
+static void clear_all(int num_irq)
+{
+    int i;
+
+    for (i = 0; i < num_irq / 32; i++) {
+        writel(ICER + i * 4, 0xffffffff);
+        writel(ICPR + i * 4, 0xffffffff);
+    }
+    for (i = 0; i < num_irq; i++) {
+        irq_set_prio(i, 0);
+    }
+}
+
+static void test_vectpending(void)
+{
+    qtest_start("-machine mps2-an511");
+
+    clear_all(NUM_IRQ);
+    g_assert_cmpuint(vectpending(), ==, 0);
+    g_assert_cmpuint(readl(ICSR) & ICSR_ISRPENDING, ==, 0);
+
+    /* A pending but disabled interrupt is not selected */
+    irq_set_prio(5, 0x80);
+    irq_write(ISPR, 5);
+    g_assert_cmpuint(vectpending(), ==, 0);
+    g_assert_cmpuint(readl(ICSR) & ICSR_ISRPENDING, ==, ICSR_ISRPENDING);
+
+    irq_write(ISER, 5);
+    g_assert_cmpuint(vectpending(), ==, 16 + 5);
+
+    /* A higher priority interrupt wins even with a higher number */
+    irq_set_prio(40, 0x40);
+    irq_write(ISER, 40);
+    irq_write(ISPR, 40);
+    g_assert_cmpuint(vectpending(), ==, 16 + 40);
+
+    /* On equal priority the lowest exception number wins */
+    irq_set_prio(40, 0x80);
+    g_assert_cmpuint(vectpending(), ==, 16 + 5);
+
+    irq_write(ICER, 5);
+    g_assert_cmpuint(vectpending(), ==, 16 + 40);
+    irq_write(ISER, 5);
+    irq_write(ICPR, 5);
+    g_assert_cmpuint(vectpending(), ==, 16 + 40);
+
+    irq_write(ICPR, 40);
+    g_assert_cmpuint(vectpending(), ==, 0);
+    g_assert_cmpuint(readl(ICSR) & ICSR_ISRPENDING, ==, 0);
+
+    clear_all(NUM_IRQ);
+
+    qtest_end();
+}
+
+static void test_bench(const void *data)
+{
+    const NVICBenchMachine *m = data;
+    g_autofree char *args = g_strdup_printf("-machine %s", m->machine);
+    double elapsed;
+    int i;
+
+    qtest_start(args);
+
+    /*
+     * Enable every interrupt but keep only one pending at a time, which
+     * is the common case the priority recomputation has to be fast for.
+     */
+    clear_all(m->num_irq);
+    for (i = 0; i < m->num_irq / 32; i++) {
+        writel(ISER + i * 4, 0xffffffff);
+    }
+
+    g_test_timer_start();
+    for (i = 0; i < BENCH_ITERATIONS; i++) {
+        int irq = i % m->num_irq;
+
+        irq_write(ISPR, irq);
+        g_assert_cmpuint(vectpending(), ==, 16 + irq);
+        irq_write(ICPR, irq);
+    }
+    elapsed = g_test_timer_elapsed();
+
+    g_test_message("%s (%d IRQs): %d pend/select/unpend cycles in %.3f s "
+                   "(%.0f cycles/s)", m->machine, m->num_irq,
+                   BENCH_ITERATIONS, elapsed, BENCH_ITERATIONS / elapsed);
+
+    clear_all(m->num_irq);
+
+    qtest_end();
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+
+    g_test_init(&argc, &argv, NULL);
+
+    qtest_add_func("/armv7m-nvic/vectpending", test_vectpending);
+    if (g_test_perf()) {
+        for (i = 0; i < ARRAY_SIZE(bench_machines); i++) {
+            const NVICBenchMachine *m = &bench_machines[i];
+            g_autofree char *path = NULL;
+
+            if (!qtest_has_machine(m->machine)) {
+                continue;
+            }
+            path = g_strdup_printf("/armv7m-nvic/bench/%s", m->machine);
+            qtest_add_data_func(path, m, test_bench);
+        }
+    }
+
+    return g_test_run();
+}
@@ -0,0 +1,87 @@
+/*
+ * QTest testcase for MMIO dispatch to the mps2 peripherals
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "qemu/osdep.h"
+#include "libqtest-single.h"
+
+/* Registers on mps2-an385 */
+#define TIMER0_VALUE 0x40000004
+#define FPGAIO_LED0 0x40028000
+#define FPGAIO_COUNTER 0x40028018
+#define SCC_ID 0x4002fffc
+#define RESERVED_4 0x40030000   /* create_unimplemented_device() */
+#define SYST_CVR 0xe000e018     /* inside the NVIC container */
+
+#define AN385_SCC_ID 0x41043850
+
+#define BENCH_ITERATIONS 100000
+
+static void test_registers(void)
+{
+    g_assert_cmphex(readl(SCC_ID), ==, AN385_SCC_ID);
+
+    writel(FPGAIO_LED0, 1);
+    g_assert_cmphex(readl(FPGAIO_LED0), ==, 1);
+    writel(FPGAIO_LED0, 0);
+    g_assert_cmphex(readl(FPGAIO_LED0), ==, 0);
+
+    g_assert_cmphex(readl(RESERVED_4), ==, 0);
+    writel(RESERVED_4, 0xdeadbeef);
+    g_assert_cmphex(readl(RESERVED_4), ==, 0);
+}
+
+static void bench_one(const char *name, uint32_t addr)
+{
+    double elapsed;
+    int i;
+
+    g_test_timer_start();
+    for (i = 0; i < BENCH_ITERATIONS; i++) {
+        readl(addr);
+    }
+    elapsed = g_test_timer_elapsed();
+
+    g_test_message("%-16s %d reads in %.3f s (%.0f reads/s)",
+                   name, BENCH_ITERATIONS, elapsed,
+                   BENCH_ITERATIONS / elapsed);
+}
+
+static void test_bench(void)
+{
+    bench_one("scc", SCC_ID);
+    bench_one("fpgaio", FPGAIO_COUNTER);
+    bench_one("apb-timer", TIMER0_VALUE);
+    bench_one("unimplemented", RESERVED_4);
+    bench_one("systick", SYST_CVR);
+}
+
+int main(int argc, char **argv)
+{
+    int r;
+
+    g_test_init(&argc, &argv, NULL);
+
+    qtest_start("-machine mps2-an385");
+
+    qtest_add_func("/mps2-mmio/registers", test_registers);
+    if (g_test_perf()) {
+        qtest_add_func("/mps2-mmio/bench", test_bench);
+    }
+
+    r = g_test_run();
+
+    qtest_end();
+
+    return r;
+}
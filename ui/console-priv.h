@@ -32,6 +32,13 @@ struct QemuConsole {
     void *hw;
     CoQueue dump_queue;
 
+    /* Damage tracking, see qemu_console_get_tile_generation() */
+    uint64_t damage_generation;
+    uint64_t damage_reset_generation;
+    uint64_t *tile_generation;
+    int tile_cols;
+    int tile_rows;
+
     QTAILQ_ENTRY(QemuConsole) next;
 };
 
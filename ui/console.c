@@ -398,6 +398,7 @@ qemu_console_finalize(Object *obj)
     g_clear_pointer(&c->surface, qemu_free_displaysurface);
     g_clear_pointer(&c->gl_unblock_timer, timer_free);
     g_clear_pointer(&c->ui_timer, timer_free);
+    g_clear_pointer(&c->tile_generation, g_free);
 }
 
 static void
@@ -606,6 +607,7 @@ void console_handle_touch_event(QemuConsole *con,
                                 Error **errp)
 {
     struct touch_slot *slot;
+    QemuInputPointer ptr;
     bool needs_sync = false;
     int update;
     int i;
@@ -640,21 +642,22 @@ void console_handle_touch_event(QemuConsole *con,
 
         if (update == INPUT_MULTI_TOUCH_TYPE_END) {
             slot->tracking_id = -1;
-            qemu_input_queue_mtt(con, update, i, slot->tracking_id);
-            needs_sync = true;
-        } else {
-            qemu_input_queue_mtt(con, update, i, slot->tracking_id);
-            qemu_input_queue_btn(con, INPUT_BUTTON_TOUCH, true);
-            qemu_input_queue_mtt_abs(con,
-                                    INPUT_AXIS_X, (int) slot->x,
-                                    0, width,
-                                    i, slot->tracking_id);
-            qemu_input_queue_mtt_abs(con,
-                                    INPUT_AXIS_Y, (int) slot->y,
-                                    0, height,
-                                    i, slot->tracking_id);
-            needs_sync = true;
         }
+        ptr = (QemuInputPointer) {
+            .slot = i,
+            .type = update,
+            .tracking_id = slot->tracking_id,
+            .x = qemu_input_scale_axis((int) slot->x, 0, width,
+                                       INPUT_EVENT_ABS_MIN,
+                                       INPUT_EVENT_ABS_MAX),
+            .y = qemu_input_scale_axis((int) slot->y, 0, height,
+                                       INPUT_EVENT_ABS_MIN,
+                                       INPUT_EVENT_ABS_MAX),
+            .buttons = 1u << INPUT_BUTTON_TOUCH,
+            .buttons_changed = 1u << INPUT_BUTTON_TOUCH,
+        };
+        qemu_input_send_pointer(con, &ptr);
+        needs_sync = true;
     }
 
     if (needs_sync) {
@@ -772,6 +775,58 @@ int dpy_set_ui_info(QemuConsole *con, QemuUIInfo *info, bool delay)
     return 0;
 }
 
+static void qemu_console_reset_damage(QemuConsole *con)
+{
+    g_clear_pointer(&con->tile_generation, g_free);
+    con->damage_reset_generation = ++con->damage_generation;
+}
+
+static void qemu_console_mark_damage(QemuConsole *con,
+                                     int x, int y, int w, int h)
+{
+    int tx, ty, tx_end, ty_end;
+    uint64_t gen;
+
+    if (w <= 0 || h <= 0 || con->scanout.kind != SCANOUT_SURFACE) {
+        return;
+    }
+
+    if (!con->tile_generation) {
+        con->tile_cols = DIV_ROUND_UP(surface_width(con->surface),
+                                      QEMU_CONSOLE_TILE_SIZE);
+        con->tile_rows = DIV_ROUND_UP(surface_height(con->surface),
+                                      QEMU_CONSOLE_TILE_SIZE);
+        con->tile_generation = g_new(uint64_t,
+                                     con->tile_cols * con->tile_rows);
+        for (tx = 0; tx < con->tile_cols * con->tile_rows; tx++) {
+            con->tile_generation[tx] = con->damage_reset_generation;
+        }
+    }
+
+    gen = ++con->damage_generation;
+    tx_end = MIN(DIV_ROUND_UP(x + w, QEMU_CONSOLE_TILE_SIZE), con->tile_cols);
+    ty_end = MIN(DIV_ROUND_UP(y + h, QEMU_CONSOLE_TILE_SIZE), con->tile_rows);
+    for (ty = y / QEMU_CONSOLE_TILE_SIZE; ty < ty_end; ty++) {
+        for (tx = x / QEMU_CONSOLE_TILE_SIZE; tx < tx_end; tx++) {
+            con->tile_generation[ty * con->tile_cols + tx] = gen;
+        }
+    }
+}
+
+uint64_t qemu_console_get_damage_generation(QemuConsole *con)
+{
+    return con->damage_generation;
+}
+
+uint64_t qemu_console_get_tile_generation(QemuConsole *con, int tx, int ty)
+{
+    if (!con->tile_generation ||
+        tx >= con->tile_cols || ty >= con->tile_rows) {
+        return con->damage_reset_generation;
+    }
+    return con->tile_generation[ty * con->tile_cols + tx];
+}
+
 void dpy_gfx_update(QemuConsole *con, int x, int y, int w, int h)
 {
     DisplayState *s = con->ds;
@@ -786,6 +841,9 @@ void dpy_gfx_update(QemuConsole *con, int x, int y, int w, int h)
     w = MIN(w, width - x);
     h = MIN(h, height - y);
 
+    /* Tracked even without listeners, screendump-tiles relies on it */
+    qemu_console_mark_damage(con, x, y, w, h);
+
     if (!qemu_console_is_visible(con)) {
         return;
     }
@@ -835,6 +893,7 @@ void dpy_gfx_replace_surface(QemuConsole *con,
 
     con->scanout.kind = SCANOUT_SURFACE;
     con->surface = new_surface;
+    qemu_console_reset_damage(con);
     dpy_gfx_create_texture(con, new_surface);
     QLIST_FOREACH(dcl, &s->listeners, next) {
         if (con != dcl->con) {
@@ -1302,6 +1361,28 @@ QemuConsole *qemu_console_lookup_by_device_name(const char *device_id,
     return con;
 }
 
+QemuConsole *qemu_console_lookup_by_qmp_args(const char *device,
+                                             bool has_head, int64_t head,
+                                             Error **errp)
+{
+    QemuConsole *con;
+
+    if (device) {
+        return qemu_console_lookup_by_device_name(device, has_head ? head : 0,
+                                                  errp);
+    }
+
+    if (has_head) {
+        error_setg(errp, "'head' must be specified together with 'device'");
+        return NULL;
+    }
+    con = qemu_console_lookup_by_index(0);
+    if (!con) {
+        error_setg(errp, "There is no console available");
+    }
+    return con;
+}
+
 static QemuConsole *qemu_graphic_console_lookup_unused(void)
 {
     QemuConsole *con;
@@ -547,6 +547,100 @@ void qemu_input_queue_mtt_abs(QemuConsole *src, InputAxis axis, int value,
     qemu_input_event_send(src, &evt);
 }
 
+uint32_t qemu_input_map_buttons(uint32_t *button_map, uint32_t mask)
+{
+    InputButton btn;
+    uint32_t buttons = 0;
+
+    for (btn = 0; btn < INPUT_BUTTON__MAX; btn++) {
+        if (mask & button_map[btn]) {
+            buttons |= 1u << btn;
+        }
+    }
+    return buttons;
+}
+
+/*
+ * Split a pointer update into individual events, for handlers without
+ * a pointer callback and for record/replay, which logs single events.
+ */
+static void qemu_input_send_pointer_events(QemuConsole *src,
+                                           const QemuInputPointer *ptr)
+{
+    InputButton btn;
+
+    if (ptr->slot == INPUT_POINTER_SLOT_MOUSE) {
+        for (btn = 0; btn < INPUT_BUTTON__MAX; btn++) {
+            if (ptr->buttons_changed & (1u << btn)) {
+                qemu_input_queue_btn(src, btn, ptr->buttons & (1u << btn));
+            }
+        }
+        qemu_input_queue_abs(src, INPUT_AXIS_X, ptr->x,
+                             INPUT_EVENT_ABS_MIN, INPUT_EVENT_ABS_MAX);
+        qemu_input_queue_abs(src, INPUT_AXIS_Y, ptr->y,
+                             INPUT_EVENT_ABS_MIN, INPUT_EVENT_ABS_MAX);
+        return;
+    }
+
+    qemu_input_queue_mtt(src, ptr->type, ptr->slot, ptr->tracking_id);
+    if (ptr->type == INPUT_MULTI_TOUCH_TYPE_END ||
+        ptr->type == INPUT_MULTI_TOUCH_TYPE_CANCEL) {
+        return;
+    }
+    for (btn = 0; btn < INPUT_BUTTON__MAX; btn++) {
+        if (ptr->buttons_changed & (1u << btn)) {
+            qemu_input_queue_btn(src, btn, ptr->buttons & (1u << btn));
+        }
+    }
+    qemu_input_queue_mtt_abs(src, INPUT_AXIS_X, ptr->x,
+                             INPUT_EVENT_ABS_MIN, INPUT_EVENT_ABS_MAX,
+                             ptr->slot, ptr->tracking_id);
+    qemu_input_queue_mtt_abs(src, INPUT_AXIS_Y, ptr->y,
+                             INPUT_EVENT_ABS_MIN, INPUT_EVENT_ABS_MAX,
+                             ptr->slot, ptr->tracking_id);
+}
+
+/*
+ * Deliver a complete pointer state.  Handlers that implement the
+ * pointer callback get it in a single call, everybody else sees the
+ * usual sequence of button and axis events.  As with the per-axis
+ * helpers, the caller finishes the update with qemu_input_event_sync().
+ */
+void qemu_input_send_pointer(QemuConsole *src, const QemuInputPointer *ptr)
+{
+    QemuInputHandlerState *s;
+    uint32_t mask;
+    int64_t latency = 0;
+    int idx = -1;
+
+    if (!runstate_is_running() && !runstate_check(RUN_STATE_SUSPENDED)) {
+        return;
+    }
+
+    mask = ptr->slot == INPUT_POINTER_SLOT_MOUSE ?
+        INPUT_EVENT_MASK_ABS : INPUT_EVENT_MASK_MTT;
+    s = qemu_input_find_handler(mask, src);
+    if (!s || !s->handler->pointer || replay_mode != REPLAY_MODE_NONE) {
+        qemu_input_send_pointer_events(src, ptr);
+        return;
+    }
+
+    if (src) {
+        idx = qemu_console_get_index(src);
+    }
+    if (ptr->timestamp) {
+        latency = qemu_clock_get_ns(QEMU_CLOCK_REALTIME) - ptr->timestamp;
+    }
+    trace_input_event_pointer(idx, ptr->slot, ptr->x, ptr->y,
+                              ptr->buttons, latency);
+    s->handler->pointer(s->dev, src, ptr);
+    s->events++;
+    if (ptr->timestamp) {
+        latency = qemu_clock_get_ns(QEMU_CLOCK_REALTIME) - ptr->timestamp;
+    }
+    trace_input_event_pointer_done(idx, ptr->slot, latency);
+}
+
 void qemu_add_mouse_mode_change_notifier(Notifier *notify)
 {
     notifier_list_add(&mouse_mode_notifiers, notify);
@@ -0,0 +1,448 @@
+/*
+ * Graphic console recorder
+ *
+ * Writes the damaged areas of a graphic console to a file, sampled on
+ * QEMU_CLOCK_VIRTUAL so that recordings are reproducible under icount.
+ * Pixels are captured in the main loop; compression and file I/O run
+ * in a dedicated thread.
+ *
+ * File format (all integers little endian):
+ *
+ *   file header:  "QEMUREC\0", u32 version (1), u32 reserved
+ *   frame:        u32 magic "QFRM", u32 flags, u64 timestamp (ns),
+ *                 u32 screen width, u32 screen height,
+ *                 u32 number of rectangles, u32 reserved
+ *   rectangle:    u32 x, u32 y, u32 width, u32 height, u32 length,
+ *                 followed by @length bytes holding the rectangle as
+ *                 a QOI image (https://qoiformat.org), RGB channels
+ *
+ * Bit 0 of the frame flags is set when the rectangles cover the whole
+ * screen, i.e. for the first frame and after a mode change.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.  See the COPYING file in the
+ * top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qapi/error.h"
+#include "qapi/qapi-commands-ui.h"
+#include "qemu/bswap.h"
+#include "qemu/error-report.h"
+#include "qemu/queue.h"
+#include "qemu/thread.h"
+#include "qemu/timer.h"
+#include "ui/console.h"
+#include "ui/rect.h"
+#include "trace.h"
+
+#define SCREEN_RECORD_VERSION       1
+#define SCREEN_RECORD_FRAME_MAGIC   0x4d524651 /* "QFRM" */
+#define SCREEN_RECORD_FLAG_KEYFRAME (1 << 0)
+#define SCREEN_RECORD_MAX_RECTS     16
+/* Frames waiting for the encoder before capture is deferred */
+#define SCREEN_RECORD_MAX_QUEUED    8
+
+typedef struct ScreenRecordRect {
+    QemuRect rect;
+    pixman_image_t *image;
+} ScreenRecordRect;
+
+typedef struct ScreenRecordFrame {
+    int64_t timestamp;
+    uint32_t flags;
+    int width;
+    int height;
+    int nr_rects;
+    ScreenRecordRect rects[SCREEN_RECORD_MAX_RECTS];
+
+    QSIMPLEQ_ENTRY(ScreenRecordFrame) next;
+} ScreenRecordFrame;
+
+typedef struct ScreenRecorder {
+    DisplayChangeListener dcl;
+    DisplaySurface *surface;
+    QEMUTimer *timer;
+    int64_t interval_ns;
+    int fd;
+
+    /* Damage accumulated since the last captured frame */
+    QemuRect rects[SCREEN_RECORD_MAX_RECTS];
+    int nr_rects;
+    bool keyframe;
+
+    /* Encoder thread, everything below is protected by @lock */
+    QemuThread thread;
+    QemuMutex lock;
+    QemuCond cond;
+    QSIMPLEQ_HEAD(, ScreenRecordFrame) frames;
+    int nr_queued;
+    bool exit;
+    int error;
+} ScreenRecorder;
+
+static ScreenRecorder *recorder;
+
+/* QOI encoder, see https://qoiformat.org/qoi-specification.pdf */
+#define QOI_OP_INDEX    0x00
+#define QOI_OP_DIFF     0x40
+#define QOI_OP_LUMA     0x80
+#define QOI_OP_RUN      0xc0
+#define QOI_OP_RGB      0xfe
+#define QOI_HEADER_SIZE 14
+
+static const uint8_t qoi_padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+static void qoi_encode(GByteArray *out, pixman_image_t *image)
+{
+    int width = pixman_image_get_width(image);
+    int height = pixman_image_get_height(image);
+    int stride = pixman_image_get_stride(image) / 4;
+    uint32_t *data = pixman_image_get_data(image);
+    uint32_t index[64] = { 0 };
+    uint32_t prev = 0;
+    uint8_t hdr[QOI_HEADER_SIZE] = { 'q', 'o', 'i', 'f' };
+    uint8_t op[4];
+    int run = 0;
+    int x, y;
+
+    stl_be_p(hdr + 4, width);
+    stl_be_p(hdr + 8, height);
+    hdr[12] = 3;    /* RGB */
+    hdr[13] = 0;    /* sRGB with linear alpha */
+    g_byte_array_append(out, hdr, sizeof(hdr));
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            uint32_t px = data[y * stride + x] & 0xffffff;
+            bool last = y == height - 1 && x == width - 1;
+            uint8_t r = px >> 16, g = px >> 8, b = px;
+            int8_t vr, vg, vb, vg_r, vg_b;
+            int hash;
+
+            if (px == prev) {
+                run++;
+                if (run == 62 || last) {
+                    op[0] = QOI_OP_RUN | (run - 1);
+                    g_byte_array_append(out, op, 1);
+                    run = 0;
+                }
+                continue;
+            }
+            if (run) {
+                op[0] = QOI_OP_RUN | (run - 1);
+                g_byte_array_append(out, op, 1);
+                run = 0;
+            }
+
+            /* Alpha is always 255 */
+            hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+            if (index[hash] == (px | 0xff000000)) {
+                op[0] = QOI_OP_INDEX | hash;
+                g_byte_array_append(out, op, 1);
+                prev = px;
+                continue;
+            }
+            index[hash] = px | 0xff000000;
+
+            vr = r - (uint8_t)(prev >> 16);
+            vg = g - (uint8_t)(prev >> 8);
+            vb = b - (uint8_t)prev;
+            vg_r = vr - vg;
+            vg_b = vb - vg;
+            if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                op[0] = QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2);
+                g_byte_array_append(out, op, 1);
+            } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 &&
+                       vg_b > -9 && vg_b < 8) {
+                op[0] = QOI_OP_LUMA | (vg + 32);
+                op[1] = (vg_r + 8) << 4 | (vg_b + 8);
+                g_byte_array_append(out, op, 2);
+            } else {
+                op[0] = QOI_OP_RGB;
+                op[1] = r;
+                op[2] = g;
+                op[3] = b;
+                g_byte_array_append(out, op, 4);
+            }
+            prev = px;
+        }
+    }
+
+    g_byte_array_append(out, qoi_padding, sizeof(qoi_padding));
+}
+
+static void screen_record_append_le32(GByteArray *out, uint32_t val)
+{
+    val = cpu_to_le32(val);
+    g_byte_array_append(out, (uint8_t *)&val, sizeof(val));
+}
+
+static void screen_record_encode_frame(GByteArray *out,
+                                       ScreenRecordFrame *frame)
+{
+    uint64_t ts = cpu_to_le64(frame->timestamp);
+    int i;
+
+    screen_record_append_le32(out, SCREEN_RECORD_FRAME_MAGIC);
+    screen_record_append_le32(out, frame->flags);
+    g_byte_array_append(out, (uint8_t *)&ts, sizeof(ts));
+    screen_record_append_le32(out, frame->width);
+    screen_record_append_le32(out, frame->height);
+    screen_record_append_le32(out, frame->nr_rects);
+    screen_record_append_le32(out, 0);
+
+    for (i = 0; i < frame->nr_rects; i++) {
+        ScreenRecordRect *r = &frame->rects[i];
+        guint len_offset;
+
+        screen_record_append_le32(out, r->rect.x);
+        screen_record_append_le32(out, r->rect.y);
+        screen_record_append_le32(out, r->rect.width);
+        screen_record_append_le32(out, r->rect.height);
+        len_offset = out->len;
+        screen_record_append_le32(out, 0);
+        qoi_encode(out, r->image);
+        stl_le_p(out->data + len_offset, out->len - len_offset - 4);
+    }
+}
+
+static void screen_record_free_frame(ScreenRecordFrame *frame)
+{
+    int i;
+
+    for (i = 0; i < frame->nr_rects; i++) {
+        qemu_pixman_image_unref(frame->rects[i].image);
+    }
+    g_free(frame);
+}
+
+static void *screen_record_thread(void *opaque)
+{
+    ScreenRecorder *rec = opaque;
+    g_autoptr(GByteArray) buf = g_byte_array_new();
+    ScreenRecordFrame *frame;
+    int error = 0;
+
+    qemu_mutex_lock(&rec->lock);
+    for (;;) {
+        /* On exit, drain the queue first */
+        while (QSIMPLEQ_EMPTY(&rec->frames) && !rec->exit) {
+            qemu_cond_wait(&rec->cond, &rec->lock);
+        }
+        frame = QSIMPLEQ_FIRST(&rec->frames);
+        if (!frame) {
+            break;
+        }
+        QSIMPLEQ_REMOVE_HEAD(&rec->frames, next);
+        qemu_mutex_unlock(&rec->lock);
+
+        g_byte_array_set_size(buf, 0);
+        screen_record_encode_frame(buf, frame);
+        trace_screen_record_write(frame->timestamp, frame->nr_rects, buf->len);
+        screen_record_free_frame(frame);
+        if (!error &&
+            qemu_write_full(rec->fd, buf->data, buf->len) != buf->len) {
+            error = errno;
+        }
+
+        qemu_mutex_lock(&rec->lock);
+        rec->nr_queued--;
+        rec->error = error;
+    }
+    qemu_mutex_unlock(&rec->lock);
+    return NULL;
+}
+
+static void screen_record_capture(ScreenRecorder *rec, bool force)
+{
+    ScreenRecordFrame *frame;
+    int i;
+
+    if (!rec->nr_rects || !rec->surface) {
+        return;
+    }
+
+    qemu_mutex_lock(&rec->lock);
+    if (!force && rec->nr_queued >= SCREEN_RECORD_MAX_QUEUED) {
+        /* Keep the damage, it goes into the next frame the encoder takes */
+        qemu_mutex_unlock(&rec->lock);
+        trace_screen_record_defer(rec->nr_queued);
+        return;
+    }
+    qemu_mutex_unlock(&rec->lock);
+
+    frame = g_new0(ScreenRecordFrame, 1);
+    frame->timestamp = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL);
+    frame->flags = rec->keyframe ? SCREEN_RECORD_FLAG_KEYFRAME : 0;
+    frame->width = surface_width(rec->surface);
+    frame->height = surface_height(rec->surface);
+    frame->nr_rects = rec->nr_rects;
+    for (i = 0; i < rec->nr_rects; i++) {
+        QemuRect *r = &rec->rects[i];
+        pixman_image_t *image;
+
+        image = pixman_image_create_bits(PIXMAN_x8r8g8b8, r->width, r->height,
+                                         NULL, 0);
+        pixman_image_composite(PIXMAN_OP_SRC, rec->surface->image, NULL,
+                               image, r->x, r->y, 0, 0, 0, 0,
+                               r->width, r->height);
+        frame->rects[i].rect = *r;
+        frame->rects[i].image = image;
+    }
+    rec->nr_rects = 0;
+    rec->keyframe = false;
+
+    qemu_mutex_lock(&rec->lock);
+    QSIMPLEQ_INSERT_TAIL(&rec->frames, frame, next);
+    rec->nr_queued++;
+    qemu_cond_signal(&rec->cond);
+    qemu_mutex_unlock(&rec->lock);
+}
+
+static void screen_record_timer(void *opaque)
+{
+    ScreenRecorder *rec = opaque;
+
+    graphic_hw_update(rec->dcl.con);
+    screen_record_capture(rec, false);
+    timer_mod(rec->timer,
+              qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) + rec->interval_ns);
+}
+
+static void screen_record_gfx_update(DisplayChangeListener *dcl,
+                                     int x, int y, int w, int h)
+{
+    ScreenRecorder *rec = container_of(dcl, ScreenRecorder, dcl);
+
+    qemu_rect_list_add(rec->rects, &rec->nr_rects, SCREEN_RECORD_MAX_RECTS,
+                       x, y, w, h);
+}
+
+static void screen_record_gfx_switch(DisplayChangeListener *dcl,
+                                     DisplaySurface *new_surface)
+{
+    ScreenRecorder *rec = container_of(dcl, ScreenRecorder, dcl);
+
+    rec->surface = new_surface;
+    rec->nr_rects = 0;
+    rec->keyframe = true;
+    qemu_rect_list_add(rec->rects, &rec->nr_rects, SCREEN_RECORD_MAX_RECTS,
+                       0, 0, surface_width(new_surface),
+                       surface_height(new_surface));
+}
+
+static bool screen_record_gfx_check_format(DisplayChangeListener *dcl,
+                                           pixman_format_code_t format)
+{
+    /* Pixels are converted when captured */
+    return true;
+}
+
+static const DisplayChangeListenerOps screen_record_dcl_ops = {
+    .dpy_name             = "screen-record",
+    .dpy_gfx_update       = screen_record_gfx_update,
+    .dpy_gfx_switch       = screen_record_gfx_switch,
+    .dpy_gfx_check_format = screen_record_gfx_check_format,
+};
+
+void qmp_screen_record_start(const char *filename, const char *device,
+                             bool has_head, int64_t head,
+                             bool has_interval, int64_t interval,
+                             Error **errp)
+{
+    static const char magic[8] = "QEMUREC";
+    ScreenRecorder *rec;
+    QemuConsole *con;
+    uint32_t hdr[2];
+    int fd;
+
+    if (recorder) {
+        error_setg(errp, "A screen recording is already in progress");
+        return;
+    }
+    if (has_interval && interval <= 0) {
+        error_setg(errp, "'interval' must be positive");
+        return;
+    }
+
+    con = qemu_console_lookup_by_qmp_args(device, has_head, head, errp);
+    if (!con) {
+        return;
+    }
+    if (!qemu_console_is_graphic(con)) {
+        error_setg(errp, "There is no graphic console to record");
+        return;
+    }
+
+    fd = qemu_create(filename, O_WRONLY | O_TRUNC | O_BINARY, 0666, errp);
+    if (fd < 0) {
+        return;
+    }
+    hdr[0] = cpu_to_le32(SCREEN_RECORD_VERSION);
+    hdr[1] = 0;
+    if (qemu_write_full(fd, magic, sizeof(magic)) != sizeof(magic) ||
+        qemu_write_full(fd, hdr, sizeof(hdr)) != sizeof(hdr)) {
+        error_setg_errno(errp, errno, "failed to write '%s'", filename);
+        qemu_close(fd);
+        qemu_unlink(filename);
+        return;
+    }
+
+    rec = g_new0(ScreenRecorder, 1);
+    rec->fd = fd;
+    rec->interval_ns = (has_interval ? interval : 40) * SCALE_MS;
+    qemu_mutex_init(&rec->lock);
+    qemu_cond_init(&rec->cond);
+    QSIMPLEQ_INIT(&rec->frames);
+    qemu_thread_create(&rec->thread, "screen_record", screen_record_thread,
+                       rec, QEMU_THREAD_JOINABLE);
+
+    rec->dcl.ops = &screen_record_dcl_ops;
+    rec->dcl.con = con;
+    register_displaychangelistener(&rec->dcl);
+
+    rec->timer = timer_new_ns(QEMU_CLOCK_VIRTUAL, screen_record_timer, rec);
+    timer_mod(rec->timer,
+              qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) + rec->interval_ns);
+
+    recorder = rec;
+    trace_screen_record_start(filename, rec->interval_ns);
+}
+
+void qmp_screen_record_stop(Error **errp)
+{
+    ScreenRecorder *rec = recorder;
+    int error;
+
+    if (!rec) {
+        error_setg(errp, "No screen recording in progress");
+        return;
+    }
+    recorder = NULL;
+
+    timer_free(rec->timer);
+    /* Flush what changed since the last tick */
+    graphic_hw_update(rec->dcl.con);
+    screen_record_capture(rec, true);
+    unregister_displaychangelistener(&rec->dcl);
+
+    qemu_mutex_lock(&rec->lock);
+    rec->exit = true;
+    qemu_cond_signal(&rec->cond);
+    qemu_mutex_unlock(&rec->lock);
+    qemu_thread_join(&rec->thread);
+
+    error = rec->error;
+    if (qemu_close(rec->fd) < 0 && !error) {
+        error = errno;
+    }
+    qemu_cond_destroy(&rec->cond);
+    qemu_mutex_destroy(&rec->lock);
+    g_free(rec);
+
+    trace_screen_record_stop(error);
+    if (error) {
+        error_setg_errno(errp, error, "Failed to write the screen recording");
+    }
+}
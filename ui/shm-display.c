@@ -0,0 +1,402 @@
+/*
+ * Shared-memory framebuffer export
+ *
+ * Publishes a graphic console into a host file (typically on a tmpfs
+ * such as /dev/shm) so that local viewers can read the pixels straight
+ * from the mapping instead of going through a VNC encoder.  The layout
+ * is described in include/ui/shm-display.h.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.  See the COPYING file in the
+ * top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qapi/error.h"
+#include "qemu/module.h"
+#include "qom/object_interfaces.h"
+#include "chardev/char-fe.h"
+#include "hw/qdev-core.h"
+#include "system/system.h"
+#include "ui/console.h"
+#include "ui/rect.h"
+#include "ui/shm-display.h"
+#include "trace.h"
+
+#include <sys/mman.h>
+
+#define TYPE_DISPLAY_SHM "display-shm"
+OBJECT_DECLARE_SIMPLE_TYPE(DisplayShm, DISPLAY_SHM)
+
+QEMU_BUILD_BUG_ON(sizeof(QemuShmDisplayHeader) > QEMU_SHM_DISPLAY_DATA_OFFSET);
+
+struct DisplayShm {
+    Object parent;
+
+    char *path;
+    char *device;
+    uint32_t head;
+    char *chr_name;
+
+    CharBackend chr;
+    Notifier machine_done;
+    DisplayChangeListener dcl;
+    DisplaySurface *surface;
+
+    int fd;
+    uint8_t *map;
+    size_t map_size;
+    QemuShmDisplayHeader *hdr;
+    pixman_image_t *image;
+
+    /* Areas written since the last published generation */
+    QemuRect rects[QEMU_SHM_DISPLAY_MAX_RECTS];
+    int nr_rects;
+    bool writing;
+};
+
+static void display_shm_begin_write(DisplayShm *s)
+{
+    if (s->writing) {
+        return;
+    }
+    qatomic_set(&s->hdr->generation, s->hdr->generation + 1);
+    smp_wmb();
+    s->writing = true;
+}
+
+static void display_shm_publish(DisplayShm *s)
+{
+    uint32_t gen;
+    int i;
+
+    if (!s->writing || !s->image) {
+        return;
+    }
+
+    s->hdr->nr_rects = s->nr_rects;
+    for (i = 0; i < s->nr_rects; i++) {
+        s->hdr->rects[i] = (QemuShmDisplayRect) {
+            .x = s->rects[i].x, .y = s->rects[i].y,
+            .w = s->rects[i].width, .h = s->rects[i].height,
+        };
+    }
+    smp_wmb();
+    gen = s->hdr->generation + 1;
+    qatomic_set(&s->hdr->generation, gen);
+    s->writing = false;
+    s->nr_rects = 0;
+
+    trace_display_shm_publish(gen, s->hdr->nr_rects);
+
+    /*
+     * Notifications are only a wakeup hint; a reader that misses one
+     * still finds the current generation in the header.
+     */
+    if (qemu_chr_fe_backend_connected(&s->chr)) {
+        uint32_t le_gen = cpu_to_le32(gen);
+
+        qemu_chr_fe_write(&s->chr, (uint8_t *)&le_gen, sizeof(le_gen));
+    }
+}
+
+static bool display_shm_map(DisplayShm *s, int width, int height,
+                            Error **errp)
+{
+    size_t stride = width * 4;
+    size_t size = QEMU_SHM_DISPLAY_DATA_OFFSET + stride * height;
+    uint8_t *map;
+
+    if (size > s->map_size) {
+        /* Never shrink the file, readers may still have it mapped */
+        if (ftruncate(s->fd, size) < 0) {
+            error_setg_errno(errp, errno, "failed to resize '%s'", s->path);
+            return false;
+        }
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0);
+        if (map == MAP_FAILED) {
+            error_setg_errno(errp, errno, "failed to map '%s'", s->path);
+            return false;
+        }
+        if (s->map) {
+            munmap(s->map, s->map_size);
+        }
+        s->map = map;
+        s->map_size = size;
+        s->hdr = (QemuShmDisplayHeader *)map;
+    }
+
+    qemu_pixman_image_unref(s->image);
+    s->image = pixman_image_create_bits(PIXMAN_x8r8g8b8, width, height,
+                                        (uint32_t *)(s->map +
+                                        QEMU_SHM_DISPLAY_DATA_OFFSET),
+                                        stride);
+
+    display_shm_begin_write(s);
+    s->hdr->magic = QEMU_SHM_DISPLAY_MAGIC;
+    s->hdr->version = QEMU_SHM_DISPLAY_VERSION;
+    s->hdr->format = PIXMAN_x8r8g8b8;
+    s->hdr->width = width;
+    s->hdr->height = height;
+    s->hdr->stride = stride;
+    s->hdr->data_offset = QEMU_SHM_DISPLAY_DATA_OFFSET;
+    return true;
+}
+
+static void display_shm_copy(DisplayShm *s, int x, int y, int w, int h)
+{
+    if (!s->surface || !s->image || w <= 0 || h <= 0) {
+        return;
+    }
+    display_shm_begin_write(s);
+    pixman_image_composite(PIXMAN_OP_SRC, s->surface->image, NULL, s->image,
+                           x, y, 0, 0, x, y, w, h);
+    qemu_rect_list_add(s->rects, &s->nr_rects, QEMU_SHM_DISPLAY_MAX_RECTS,
+                       x, y, w, h);
+}
+
+static void display_shm_gfx_update(DisplayChangeListener *dcl,
+                                   int x, int y, int w, int h)
+{
+    DisplayShm *s = container_of(dcl, DisplayShm, dcl);
+
+    display_shm_copy(s, x, y, w, h);
+}
+
+static void display_shm_gfx_switch(DisplayChangeListener *dcl,
+                                   DisplaySurface *new_surface)
+{
+    DisplayShm *s = container_of(dcl, DisplayShm, dcl);
+    int width = surface_width(new_surface);
+    int height = surface_height(new_surface);
+
+    s->surface = new_surface;
+    trace_display_shm_switch(width, height);
+
+    if (!s->image || s->hdr->width != width || s->hdr->height != height) {
+        Error *err = NULL;
+
+        s->nr_rects = 0;
+        if (!display_shm_map(s, width, height, &err)) {
+            /*
+             * Stop publishing until the next resize manages to map the
+             * file; the old image no longer matches the surface.
+             */
+            error_reportf_err(err, "display-shm: ");
+            qemu_pixman_image_unref(s->image);
+            s->image = NULL;
+            return;
+        }
+    }
+    display_shm_copy(s, 0, 0, width, height);
+}
+
+static bool display_shm_gfx_check_format(DisplayChangeListener *dcl,
+                                         pixman_format_code_t format)
+{
+    /* Any format pixman can read is converted while copying */
+    return true;
+}
+
+static void display_shm_refresh(DisplayChangeListener *dcl)
+{
+    DisplayShm *s = container_of(dcl, DisplayShm, dcl);
+
+    graphic_hw_update(dcl->con);
+    display_shm_publish(s);
+}
+
+static const DisplayChangeListenerOps display_shm_dcl_ops = {
+    .dpy_name             = "display-shm",
+    .dpy_refresh          = display_shm_refresh,
+    .dpy_gfx_update       = display_shm_gfx_update,
+    .dpy_gfx_switch       = display_shm_gfx_switch,
+    .dpy_gfx_check_format = display_shm_gfx_check_format,
+};
+
+static bool display_shm_attach(DisplayShm *s, Error **errp)
+{
+    QemuConsole *con;
+
+    if (s->device) {
+        con = qemu_console_lookup_by_device_name(s->device, s->head, errp);
+        if (!con) {
+            return false;
+        }
+    } else {
+        con = qemu_console_lookup_default();
+    }
+    if (!qemu_console_is_graphic(con)) {
+        error_setg(errp, "display-shm needs a graphic console");
+        return false;
+    }
+
+    s->dcl.ops = &display_shm_dcl_ops;
+    s->dcl.con = con;
+    register_displaychangelistener(&s->dcl);
+    return true;
+}
+
+static void display_shm_machine_done(Notifier *notifier, void *data)
+{
+    DisplayShm *s = container_of(notifier, DisplayShm, machine_done);
+
+    display_shm_attach(s, &error_fatal);
+}
+
+static void display_shm_complete(UserCreatable *uc, Error **errp)
+{
+    DisplayShm *s = DISPLAY_SHM(uc);
+
+    if (!s->path) {
+        error_setg(errp, "display-shm needs a 'path'");
+        return;
+    }
+    if (s->head && !s->device) {
+        error_setg(errp, "'head' must be specified together with 'device'");
+        return;
+    }
+
+    if (s->chr_name) {
+        Chardev *chr = qemu_chr_find(s->chr_name);
+
+        if (!chr) {
+            error_set(errp, ERROR_CLASS_DEVICE_NOT_FOUND,
+                      "Device '%s' not found", s->chr_name);
+            return;
+        }
+        if (!qemu_chr_fe_init(&s->chr, chr, errp)) {
+            return;
+        }
+    }
+
+    s->fd = qemu_create(s->path, O_RDWR | O_TRUNC, 0600, errp);
+    if (s->fd < 0) {
+        return;
+    }
+
+    /* Consoles only exist once the machine has been created */
+    if (phase_check(PHASE_MACHINE_READY)) {
+        display_shm_attach(s, errp);
+        return;
+    }
+    s->machine_done.notify = display_shm_machine_done;
+    qemu_add_machine_init_done_notifier(&s->machine_done);
+}
+
+static char *display_shm_get_path(Object *obj, Error **errp)
+{
+    DisplayShm *s = DISPLAY_SHM(obj);
+
+    return g_strdup(s->path);
+}
+
+static void display_shm_set_path(Object *obj, const char *value,
+                                 Error **errp)
+{
+    DisplayShm *s = DISPLAY_SHM(obj);
+
+    g_free(s->path);
+    s->path = g_strdup(value);
+}
+
+static char *display_shm_get_device(Object *obj, Error **errp)
+{
+    DisplayShm *s = DISPLAY_SHM(obj);
+
+    return g_strdup(s->device);
+}
+
+static void display_shm_set_device(Object *obj, const char *value,
+                                   Error **errp)
+{
+    DisplayShm *s = DISPLAY_SHM(obj);
+
+    g_free(s->device);
+    s->device = g_strdup(value);
+}
+
+static char *display_shm_get_chardev(Object *obj, Error **errp)
+{
+    DisplayShm *s = DISPLAY_SHM(obj);
+
+    return g_strdup(s->chr_name);
+}
+
+static void display_shm_set_chardev(Object *obj, const char *value,
+                                    Error **errp)
+{
+    DisplayShm *s = DISPLAY_SHM(obj);
+
+    g_free(s->chr_name);
+    s->chr_name = g_strdup(value);
+}
+
+static void display_shm_instance_init(Object *obj)
+{
+    DisplayShm *s = DISPLAY_SHM(obj);
+
+    s->fd = -1;
+    object_property_add_uint32_ptr(obj, "head", &s->head,
+                                   OBJ_PROP_FLAG_READWRITE);
+}
+
+static void display_shm_instance_finalize(Object *obj)
+{
+    DisplayShm *s = DISPLAY_SHM(obj);
+
+    if (s->dcl.ds) {
+        unregister_displaychangelistener(&s->dcl);
+    }
+    if (s->machine_done.notify) {
+        qemu_remove_machine_init_done_notifier(&s->machine_done);
+    }
+    qemu_chr_fe_deinit(&s->chr, false);
+    qemu_pixman_image_unref(s->image);
+    if (s->map) {
+        munmap(s->map, s->map_size);
+    }
+    if (s->fd >= 0) {
+        qemu_close(s->fd);
+    }
+    g_free(s->path);
+    g_free(s->device);
+    g_free(s->chr_name);
+}
+
+static void display_shm_class_init(ObjectClass *oc, const void *data)
+{
+    UserCreatableClass *ucc = USER_CREATABLE_CLASS(oc);
+
+    ucc->complete = display_shm_complete;
+
+    object_class_property_add_str(oc, "path",
+                                  display_shm_get_path,
+                                  display_shm_set_path);
+    object_class_property_add_str(oc, "device",
+                                  display_shm_get_device,
+                                  display_shm_set_device);
+    object_class_property_add_str(oc, "chardev",
+                                  display_shm_get_chardev,
+                                  display_shm_set_chardev);
+}
+
+static const TypeInfo display_shm_info = {
+    .name = TYPE_DISPLAY_SHM,
+    .parent = TYPE_OBJECT,
+    .class_init = display_shm_class_init,
+    .instance_size = sizeof(DisplayShm),
+    .instance_init = display_shm_instance_init,
+    .instance_finalize = display_shm_instance_finalize,
+    .interfaces = (const InterfaceInfo[]) {
+        { TYPE_USER_CREATABLE },
+        { }
+    }
+};
+
+static void register_types(void)
+{
+    type_register_static(&display_shm_info);
+}
+
+type_init(register_types);
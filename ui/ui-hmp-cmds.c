@@ -459,6 +459,33 @@ hmp_screendump(Monitor *mon, const QDict *qdict)
 end:
     hmp_handle_error(mon, err);
 }
+
+void hmp_screen_record_start(Monitor *mon, const QDict *qdict)
+{
+    const char *filename = qdict_get_str(qdict, "filename");
+    const char *id = qdict_get_try_str(qdict, "device");
+    int64_t head = qdict_get_try_int(qdict, "head", 0);
+    const char *interval_str = qdict_get_try_str(qdict, "interval");
+    int64_t interval = 0;
+    Error *err = NULL;
+
+    if (interval_str && qemu_strtoi64(interval_str, NULL, 10, &interval) < 0) {
+        monitor_printf(mon, "invalid interval '%s'\n", interval_str);
+        return;
+    }
+
+    qmp_screen_record_start(filename, id, id != NULL, head,
+                            interval_str != NULL, interval, &err);
+    hmp_handle_error(mon, err);
+}
+
+void hmp_screen_record_stop(Monitor *mon, const QDict *qdict)
+{
+    Error *err = NULL;
+
+    qmp_screen_record_stop(&err);
+    hmp_handle_error(mon, err);
+}
 #endif
 
 void hmp_client_migrate_info(Monitor *mon, const QDict *qdict)
@@ -15,6 +15,7 @@
 
 #include "qemu/osdep.h"
 
+#include "block/thread-pool.h"
 #include "io/channel-file.h"
 #include "monitor/qmp-helpers.h"
 #include "qapi/qapi-commands-ui.h"
@@ -296,29 +297,25 @@ static bool png_save(int fd, pixman_image_t *image, Error **errp)
 
 #endif /* CONFIG_PNG */
 
-static bool ppm_save(int fd, pixman_image_t *image, Error **errp)
+/* Write the @width x @height area at @x, @y of @image as one PPM image */
+static bool ppm_save_rect(QIOChannel *ioc, pixman_image_t *image,
+                          int x, int y, int width, int height, Error **errp)
 {
-    int width = pixman_image_get_width(image);
-    int height = pixman_image_get_height(image);
-    g_autoptr(Object) ioc = OBJECT(qio_channel_file_new_fd(fd));
     g_autofree char *header = NULL;
     g_autoptr(pixman_image_t) linebuf = NULL;
-    int y;
-
-    trace_ppm_save(fd, image);
+    int i;
 
     header = g_strdup_printf("P6\n%d %d\n%d\n", width, height, 255);
-    if (qio_channel_write_all(QIO_CHANNEL(ioc),
-                              header, strlen(header), errp) < 0) {
+    if (qio_channel_write_all(ioc, header, strlen(header), errp) < 0) {
         return false;
     }
 
     linebuf = qemu_pixman_linebuf_create(PIXMAN_BE_r8g8b8, width);
-    for (y = 0; y < height; y++) {
-        qemu_pixman_linebuf_fill(linebuf, image, width, 0, y);
-        if (qio_channel_write_all(QIO_CHANNEL(ioc),
+    for (i = 0; i < height; i++) {
+        qemu_pixman_linebuf_fill(linebuf, image, width, x, y + i);
+        if (qio_channel_write_all(ioc,
                                   (char *)pixman_image_get_data(linebuf),
-                                  pixman_image_get_stride(linebuf), errp) < 0) {
+                                  width * 3, errp) < 0) {
             return false;
         }
     }
@@ -326,6 +323,55 @@ static bool ppm_save(int fd, pixman_image_t *image, Error **errp)
     return true;
 }
 
+static bool ppm_save(int fd, pixman_image_t *image, Error **errp)
+{
+    g_autoptr(Object) ioc = OBJECT(qio_channel_file_new_fd(fd));
+
+    trace_ppm_save(fd, image);
+
+    return ppm_save_rect(QIO_CHANNEL(ioc), image, 0, 0,
+                         pixman_image_get_width(image),
+                         pixman_image_get_height(image), errp);
+}
+
+typedef struct ScreendumpJob {
+    int fd;
+    pixman_image_t *image;
+    ImageFormat format;
+    Error *err;
+} ScreendumpJob;
+
+/* Runs in a worker thread, without the BQL */
+static int screendump_encode(void *opaque)
+{
+    ScreendumpJob *job = opaque;
+    bool ok;
+
+    if (job->format == IMAGE_FORMAT_PNG) {
+        ok = png_save(job->fd, job->image, &job->err);
+    } else {
+        ok = ppm_save(job->fd, job->image, &job->err);
+    }
+    return ok ? 0 : -EIO;
+}
+
+/*
+ * Copy the surface so that the encoder thread neither races with the
+ * device rendering into it nor depends on the lifetime of the device
+ * memory it may point to.
+ */
+static pixman_image_t *screendump_copy_image(pixman_image_t *src)
+{
+    int width = pixman_image_get_width(src);
+    int height = pixman_image_get_height(src);
+    pixman_image_t *copy;
+
+    copy = pixman_image_create_bits(PIXMAN_x8r8g8b8, width, height, NULL, 0);
+    pixman_image_composite(PIXMAN_OP_SRC, src, NULL, copy,
+                           0, 0, 0, 0, 0, 0, width, height);
+    return copy;
+}
+
 /* Safety: coroutine-only, concurrent-coroutine safe, main thread only */
 void coroutine_fn
 qmp_screendump(const char *filename, const char *device,
@@ -333,41 +379,29 @@ qmp_screendump(const char *filename, const char *device,
                bool has_format, ImageFormat format, Error **errp)
 {
     g_autoptr(pixman_image_t) image = NULL;
+    ScreendumpJob job = {};
     QemuConsole *con;
     DisplaySurface *surface;
     int fd;
 
-    if (device) {
-        con = qemu_console_lookup_by_device_name(device, has_head ? head : 0,
-                                                 errp);
-        if (!con) {
-            return;
-        }
-    } else {
-        if (has_head) {
-            error_setg(errp, "'head' must be specified together with 'device'");
-            return;
-        }
-        con = qemu_console_lookup_by_index(0);
-        if (!con) {
-            error_setg(errp, "There is no console to take a screendump from");
-            return;
-        }
+    con = qemu_console_lookup_by_qmp_args(device, has_head, head, errp);
+    if (!con) {
+        return;
     }
 
     qemu_console_co_wait_update(con);
 
     /*
      * All pending coroutines are woken up, while the BQL is held.  No
-     * further graphic update are possible until it is released.  Take
-     * an image ref before that.
+     * further graphic update are possible until it is released.  Copy
+     * the image before that, so that the dump is a consistent frame.
      */
     surface = qemu_console_surface(con);
     if (!surface) {
         error_setg(errp, "no surface");
         return;
     }
-    image = pixman_image_ref(surface->image);
+    image = screendump_copy_image(surface->image);
 
     fd = qemu_open_old(filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
     if (fd == -1) {
@@ -377,20 +411,94 @@ qmp_screendump(const char *filename, const char *device,
     }
 
     /*
-     * The image content could potentially be updated as the coroutine
-     * yields and releases the BQL. It could produce corrupted dump, but
-     * it should be otherwise safe.
+     * Encoding a large surface, PNG in particular, takes long enough to
+     * disturb guest timers and input if done in the main loop.  Hand it
+     * to a worker thread and let the coroutine yield until it is done.
      */
-    if (has_format && format == IMAGE_FORMAT_PNG) {
-        /* PNG format specified for screendump */
-        if (!png_save(fd, image, errp)) {
-            qemu_unlink(filename);
+    job.fd = fd;
+    job.image = image;
+    job.format = has_format ? format : IMAGE_FORMAT_PPM;
+    if (thread_pool_submit_co(screendump_encode, &job) < 0) {
+        error_propagate(errp, job.err);
+        qemu_unlink(filename);
+    }
+}
+
+/* Safety: coroutine-only, concurrent-coroutine safe, main thread only */
+ScreendumpTiles * coroutine_fn
+qmp_screendump_tiles(const char *filename, const char *device,
+                     bool has_head, int64_t head,
+                     bool has_since, uint64_t since, Error **errp)
+{
+    g_autoptr(pixman_image_t) image = NULL;
+    g_autoptr(Object) ioc = NULL;
+    g_autoptr(ScreendumpTiles) info = NULL;
+    ScreendumpTileList **tail;
+    QemuConsole *con;
+    DisplaySurface *surface;
+    int width, height, tx, ty;
+    int fd;
+
+    con = qemu_console_lookup_by_qmp_args(device, has_head, head, errp);
+    if (!con) {
+        return NULL;
+    }
+
+    qemu_console_co_wait_update(con);
+
+    /*
+     * Like screendump, snapshot the damage state and take an image ref
+     * while the BQL is still held.
+     */
+    surface = qemu_console_surface(con);
+    if (!surface) {
+        error_setg(errp, "no surface");
+        return NULL;
+    }
+    image = pixman_image_ref(surface->image);
+    width = pixman_image_get_width(image);
+    height = pixman_image_get_height(image);
+
+    info = g_new0(ScreendumpTiles, 1);
+    info->generation = qemu_console_get_damage_generation(con);
+    info->width = width;
+    info->height = height;
+    tail = &info->tiles;
+    for (ty = 0; ty * QEMU_CONSOLE_TILE_SIZE < height; ty++) {
+        for (tx = 0; tx * QEMU_CONSOLE_TILE_SIZE < width; tx++) {
+            ScreendumpTile *tile;
+
+            if (has_since &&
+                qemu_console_get_tile_generation(con, tx, ty) <= since) {
+                continue;
+            }
+            tile = g_new0(ScreendumpTile, 1);
+            tile->x = tx * QEMU_CONSOLE_TILE_SIZE;
+            tile->y = ty * QEMU_CONSOLE_TILE_SIZE;
+            tile->width = MIN(QEMU_CONSOLE_TILE_SIZE, width - tile->x);
+            tile->height = MIN(QEMU_CONSOLE_TILE_SIZE, height - tile->y);
+            QAPI_LIST_APPEND(tail, tile);
         }
-    } else {
-        /* PPM format specified/default for screendump */
-        if (!ppm_save(fd, image, errp)) {
+    }
+
+    fd = qemu_open_old(filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+    if (fd == -1) {
+        error_setg(errp, "failed to open file '%s': %s", filename,
+                   strerror(errno));
+        return NULL;
+    }
+    ioc = OBJECT(qio_channel_file_new_fd(fd));
+
+    for (ScreendumpTileList *l = info->tiles; l; l = l->next) {
+        ScreendumpTile *tile = l->value;
+
+        if (!ppm_save_rect(QIO_CHANNEL(ioc), image, tile->x, tile->y,
+                           tile->width, tile->height, errp)) {
             qemu_unlink(filename);
+            return NULL;
         }
     }
+
+    return g_steal_pointer(&info);
 }
 #endif /* CONFIG_PIXMAN */
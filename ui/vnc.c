@@ -1597,6 +1597,7 @@ static int vnc_client_read(VncState *vs)
         }
         return 0;
     }
+    vs->input_timestamp = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
 
     while (vs->read_handler && vs->input.offset >= vs->read_handler_expect) {
         size_t len = vs->read_handler_expect;
@@ -1799,15 +1800,33 @@ static void pointer_event(VncState *vs, int button_mask, int x, int y)
     int width = pixman_image_get_width(vs->vd->server);
     int height = pixman_image_get_height(vs->vd->server);
 
+    trace_vnc_pointer_event(vs, button_mask, x, y, vs->input_timestamp);
+
+    if (vs->absolute) {
+        QemuInputPointer ptr = {
+            .slot = INPUT_POINTER_SLOT_MOUSE,
+            .x = qemu_input_scale_axis(x, 0, width, INPUT_EVENT_ABS_MIN,
+                                       INPUT_EVENT_ABS_MAX),
+            .y = qemu_input_scale_axis(y, 0, height, INPUT_EVENT_ABS_MIN,
+                                       INPUT_EVENT_ABS_MAX),
+            .buttons = qemu_input_map_buttons(bmap, button_mask),
+            .buttons_changed = qemu_input_map_buttons(bmap, vs->last_bmask ^
+                                                      button_mask),
+            .timestamp = vs->input_timestamp,
+        };
+
+        qemu_input_send_pointer(con, &ptr);
+        vs->last_bmask = button_mask;
+        qemu_input_event_sync();
+        return;
+    }
+
     if (vs->last_bmask != button_mask) {
         qemu_input_update_buttons(con, bmap, vs->last_bmask, button_mask);
         vs->last_bmask = button_mask;
     }
 
-    if (vs->absolute) {
-        qemu_input_queue_abs(con, INPUT_AXIS_X, x, 0, width);
-        qemu_input_queue_abs(con, INPUT_AXIS_Y, y, 0, height);
-    } else if (vnc_has_feature(vs, VNC_FEATURE_POINTER_TYPE_CHANGE)) {
+    if (vnc_has_feature(vs, VNC_FEATURE_POINTER_TYPE_CHANGE)) {
         qemu_input_queue_rel(con, INPUT_AXIS_X, x - 0x7FFF);
         qemu_input_queue_rel(con, INPUT_AXIS_Y, y - 0x7FFF);
     } else {
@@ -282,6 +282,7 @@ struct VncState
     int last_x;
     int last_y;
     uint32_t last_bmask;
+    int64_t input_timestamp; /* QEMU_CLOCK_REALTIME of the last socket read */
     size_t client_width; /* limited to u16 by RFB proto */
     size_t client_height; /* limited to u16 by RFB proto */
     VncShareMode share_mode;